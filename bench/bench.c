@@ -0,0 +1,298 @@
+/************************************************************************************************
+Copyright (c) 2023, Emiliano Arnedo <emiarnedo@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** \brief Benchmarks de los modulos reloj y pantalla en el host
+ **
+ ** Mide el costo por operacion de las funciones que corren en los caminos de alta frecuencia
+ ** (1 kHz) usando un driver de pantalla falso. La salida es CSV para que pueda procesarse y,
+ ** si se pasa un archivo de referencia, marca las mediciones que empeoraron.
+ **
+ ** Uso: bench.out [referencia.csv] [tolerancia en %]
+ **
+ ** Termina con 2 si no puede leer la referencia y con 3 si alguna medicion empeoro. Los
+ ** comportamientos que se miden aca se verifican en pruebas.c.
+ **
+ ** \addtogroup bench Benchmarks
+ ** \brief Benchmarks de host
+ ** @{ */
+
+/* === Headers files inclusions =============================================================== */
+
+#include "escenarios.h"
+#include "barrido.h"
+#include "tiempo.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* === Macros definitions ====================================================================== */
+
+#define ITERACIONES       10000000 // cantidad de llamadas por medicion
+#define MAX_REFERENCIAS   32
+#define TOLERANCIA_PORDEF 25  // porcentaje de empeoramiento aceptado
+#define PERIODO_BARRIDO   100 // microsegundos por paso en la emulacion del barrido
+#define LARGO_TRAFICO     2000 // bytes que se envian a 115200 baudios para medir el caudal
+#define LARGO_ANILLO      256  // bytes del anillo de transmision del puerto serie emulado
+#define ECOS              100  // bytes que van y vuelven para medir la latencia
+
+/* === Private data type declarations ========================================================== */
+
+typedef struct referencia_s {
+    char nombre[48];
+    double ns_op;
+} referencia_s;
+
+/* === Private variable declarations =========================================================== */
+
+/* === Private function declarations =========================================================== */
+
+static int CargarReferencias(const char * archivo);
+static bool Informar(const char * nombre, long iteraciones, double inicio);
+
+/* === Public variable definitions ============================================================= */
+
+/* === Private variable definitions ============================================================ */
+
+static referencia_s referencias[MAX_REFERENCIAS];
+static int cantidad_referencias;
+static double tolerancia = TOLERANCIA_PORDEF;
+
+/* === Private function implementation ========================================================= */
+
+static int CargarReferencias(const char * archivo) {
+    char linea[128];
+    FILE * entrada = fopen(archivo, "r");
+
+    if (entrada == NULL) {
+        fprintf(stderr, "bench: no se pudo abrir la referencia %s\n", archivo);
+        return -1;
+    }
+    while (fgets(linea, sizeof(linea), entrada) && cantidad_referencias < MAX_REFERENCIAS) {
+        referencia_s * referencia = &referencias[cantidad_referencias];
+        long iteraciones;
+        if (sscanf(linea, "%47[^,],%ld,%lf", referencia->nombre, &iteraciones,
+                   &referencia->ns_op) == 3) {
+            cantidad_referencias++;
+        }
+    }
+    fclose(entrada);
+    return cantidad_referencias;
+}
+
+// Imprime una linea CSV con la medicion y devuelve false si empeoro respecto a la referencia
+static bool Informar(const char * nombre, long iteraciones, double inicio) {
+    double ns_op = (EscenarioAhora() - inicio) / iteraciones;
+    const char * estado = "-";
+    double base = 0;
+    bool resultado = true;
+
+    for (int i = 0; i < cantidad_referencias; i++) {
+        if (strcmp(referencias[i].nombre, nombre) == 0) {
+            base = referencias[i].ns_op;
+            estado = "ok";
+            if (ns_op > base * (1 + tolerancia / 100)) {
+                estado = "regresion";
+                resultado = false;
+            }
+            break;
+        }
+    }
+    printf("%s,%ld,%.3f,%.3f,%s\n", nombre, iteraciones, ns_op, base, estado);
+    return resultado;
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(int argc, char * argv[]) {
+    bool en_tiempo = true; // ninguna medicion empeoro respecto a la referencia
+    double inicio;
+    long i;
+
+    if (argc > 1 && CargarReferencias(argv[1]) < 0) {
+        return 2;
+    }
+    if (argc > 2) {
+        tolerancia = atof(argv[2]);
+    }
+
+    printf("benchmark,iteraciones,ns_op,referencia_ns_op,estado\n");
+
+    reloj_t reloj = ClockCreate(TICKS_PER_SECOND, EscenarioDisparar);
+    display_t display = DisplayCreate(4, &ESCENARIO_DRIVER);
+    modos_t modos = ModosCrear(reloj, display);
+
+    // Ida y vuelta entre minutos y horas: cada evento ejecuta la accion de entrada del modo
+    ModosProcesar(modos, EVENTO_F4);
+    inicio = EscenarioAhora();
+    for (i = 0; i < ITERACIONES / 10; i++) {
+        ModosProcesar(modos, (i & 1) ? EVENTO_CANCELAR : EVENTO_ACEPTAR);
+    }
+    en_tiempo &= Informar("modos_procesar", i, inicio);
+
+    uint8_t numeros_hora[6];
+    SetClockTime(reloj, (uint8_t[]){2, 3, 5, 9, 0, 0}, 6);
+    SetAlarmTime(reloj, (uint8_t[]){0, 7, 3, 0});
+
+    // Camino de 1 kHz: la mayoria de las llamadas solo incrementan el contador
+    inicio = EscenarioAhora();
+    for (i = 0; i < ITERACIONES; i++) {
+        RelojNuevoTick(reloj);
+    }
+    en_tiempo &= Informar("reloj_nuevo_tick", i, inicio);
+
+    // Cada llamada completa un segundo, empezando cerca de la medianoche para incluir los
+    // desbordes de minutos, horas y dias
+    uint32_t tick = ClockNextEventTick(reloj);
+    inicio = EscenarioAhora();
+    for (i = 0; i < ITERACIONES / 10; i++) {
+        ClockGetTimeAt(reloj, tick);
+        tick += TICKS_PER_SECOND;
+    }
+    en_tiempo &= Informar("nuevo_segundo", i, inicio);
+
+    // Verificacion de alarmas con la tabla llena de alarmas que no coinciden
+    for (int a = 0; AgregarAlarma(reloj, &(struct alarma_config_s){
+                                             .hora = {1, a % 10, 0, 0},
+                                             .dias = ALARMA_TODOS_LOS_DIAS,
+                                             .repetir = true,
+                                         }) >= 0;
+         a++) {
+    }
+    inicio = EscenarioAhora();
+    for (i = 0; i < ITERACIONES; i++) {
+        VerificarAlarma(reloj);
+    }
+    en_tiempo &= Informar("verificar_alarma", i, inicio);
+
+    inicio = EscenarioAhora();
+    for (i = 0; i < ITERACIONES; i++) {
+        GetClockTime(reloj, numeros_hora, sizeof(numeros_hora));
+    }
+    en_tiempo &= Informar("get_clock_time", i, inicio);
+
+    display = DisplayCreate(4, &ESCENARIO_DRIVER);
+    uint8_t numeros[4] = {1, 2, 3, 4};
+    inicio = EscenarioAhora();
+    for (i = 0; i < ITERACIONES; i++) {
+        numeros[3] = i & 0x07;
+        DisplayWriteBCD(display, numeros, sizeof(numeros));
+    }
+    en_tiempo &= Informar("display_write_bcd", i, inicio);
+
+    DisplayFlashDigits(display, 0, 1, 250);
+    inicio = EscenarioAhora();
+    for (i = 0; i < ITERACIONES; i++) {
+        DisplayRefresh(display);
+    }
+    en_tiempo &= Informar("display_refresh", i, inicio);
+
+    // Con el barrido por hardware emulado escribir la pantalla incluye cargar las tablas
+    BarridoIniciar(PERIODO_BARRIDO, (const uint32_t[BARRIDO_PUERTOS]){[0] = 0x0F, [2] = 0xFF});
+    display = DisplayCreate(4, &ESCENARIO_DRIVER_BARRIDO);
+    DisplayFlashDigits(display, 0, 1, 250);
+    inicio = EscenarioAhora();
+    for (i = 0; i < ITERACIONES / 10; i++) {
+        numeros[3] = i & 0x07;
+        DisplayWriteBCD(display, numeros, sizeof(numeros));
+    }
+    en_tiempo &= Informar("display_write_bcd_barrido", i, inicio);
+
+    // Reloj sobre el reloj monotonico del sistema: cada consulta lee la fuente, sin trabajo por
+    // tick
+    reloj = ClockCreateFromSource(FUENTE_MONOTONICA, EscenarioDisparar);
+    SetClockTime(reloj, (uint8_t[]){1, 2, 0, 0, 0, 0}, 6);
+    inicio = EscenarioAhora();
+    for (i = 0; i < ITERACIONES / 10; i++) {
+        ClockUpdate(reloj);
+    }
+    en_tiempo &= Informar("clock_update_fuente", i, inicio);
+
+    static uint32_t registro[ESCENARIO_MAX_REGISTRO];
+    inicio = EscenarioAhora();
+    for (i = 0; i < ITERACIONES / 100; i++) {
+        EscenarioSemana(true, registro);
+    }
+    en_tiempo &= Informar("reloj_advance_semana", i, inicio);
+
+    // Una semana de teclas y alarmas con el tiempo simulado, lo mas rapido posible
+    uint8_t hora[6];
+    inicio = EscenarioAhora();
+    for (i = 0; i < ITERACIONES / 1000; i++) {
+        EscenarioGuion(ESCENARIO_GUION_SEMANA, &modos, hora);
+    }
+    en_tiempo &= Informar("simulacion_semana", i, inicio);
+
+    // Pedido completo del protocolo remoto: recepcion, ejecucion y respuesta
+    static uint8_t respuesta[PROTOCOLO_MAX_TRAMA];
+    uint8_t estado[] = {PROTOCOLO_LEER_ESTADO, 4, 0, 0};
+    reloj = ClockCreate(TICKS_PER_SECOND, EscenarioDisparar);
+    modos = ModosCrear(reloj, display);
+    protocolo_t protocolo = ProtocoloCrear(reloj, modos);
+    inicio = EscenarioAhora();
+    for (i = 0; i < ITERACIONES / 100; i++) {
+        EscenarioPedir(protocolo, estado, sizeof(estado) - 2, respuesta);
+    }
+    en_tiempo &= Informar("protocolo_pedido_estado", i, inicio);
+
+    // Caudal a 115200 baudios a traves del anillo de transmision, el puerto serie emulado marca
+    // el ritmo de la linea y el costo por byte tiene que quedar cerca de los 87 us de 10 bits
+    static uint8_t anillo[LARGO_ANILLO], trafico[LARGO_TRAFICO], recibido[LARGO_TRAFICO];
+    hal_sci_line_t linea = &(struct hal_sci_line_s){
+        .baud_rate = 115200,
+        .data_bits = 8,
+        .parity = HAL_SCI_NO_PARITY,
+    };
+    if (SciSetConfig(HAL_SCI_POSIX1, linea, NULL) &&
+        SciSetBuffers(HAL_SCI_POSIX1, &(struct hal_sci_buffers_s){
+                                          .tx_data = anillo,
+                                          .tx_size = sizeof(anillo),
+                                          .tx_low_water = sizeof(anillo) / 2,
+                                      })) {
+        int enviados = 0;
+        inicio = EscenarioAhora();
+        while (enviados < LARGO_TRAFICO) {
+            enviados += SciSendData(HAL_SCI_POSIX1, &trafico[enviados], LARGO_TRAFICO - enviados);
+            if (enviados < LARGO_TRAFICO) {
+                nanosleep(&(struct timespec){.tv_nsec = 1000000}, NULL);
+            }
+        }
+        EscenarioRecibir(SciPosixPeer(HAL_SCI_POSIX1), recibido, LARGO_TRAFICO);
+        en_tiempo &= Informar("sci_115200_byte", LARGO_TRAFICO, inicio);
+    }
+
+    // Latencia de ida y vuelta de un byte a 115200 baudios, con el eco hecho desde el evento
+    if (SciSetConfig(HAL_SCI_POSIX0, linea, NULL)) {
+        int extremo = SciPosixPeer(HAL_SCI_POSIX0);
+        SciSetEventHandler(HAL_SCI_POSIX0, EscenarioEco, NULL);
+        inicio = EscenarioAhora();
+        for (i = 0; i < ECOS; i++) {
+            uint8_t dato = i;
+            if (write(extremo, &dato, 1) == 1) {
+                EscenarioRecibir(extremo, &dato, 1);
+            }
+        }
+        en_tiempo &= Informar("sci_115200_eco", ECOS, inicio);
+    }
+
+    return en_tiempo ? 0 : 3;
+}
+
+/* === End of documentation ==================================================================== */
+
+/** @} End of module definition for doxygen */
@@ -0,0 +1,272 @@
+/************************************************************************************************
+Copyright (c) 2023, Emiliano Arnedo <emiarnedo@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** \brief Escenarios de host compartidos por los benchmarks y las pruebas
+ **
+ ** \addtogroup bench Benchmarks
+ ** @{ */
+
+/* === Headers files inclusions =============================================================== */
+
+#include "escenarios.h"
+#include "barrido.h"
+#include "simulacion.h"
+#include "tiempo.h"
+#include <poll.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* === Macros definitions ====================================================================== */
+
+#define SEGUNDOS_SEMANA (7 * 24 * 3600)
+#define MAX_PASOS_GUION 64
+
+/* === Private data type declarations ========================================================== */
+
+/* === Private variable declarations =========================================================== */
+
+/* === Private function declarations =========================================================== */
+
+static void ScreenTurnOff(void);
+static void SegmentsTurnOn(uint8_t segments);
+static void DigitTurnOn(uint8_t digit);
+static void ScanFrames(const uint8_t * frame_on, const uint8_t * frame_off, uint8_t digits,
+                       uint16_t flashing_steps);
+static void Registrar(reloj_t reloj, bool act_desact);
+
+/* === Public variable definitions ============================================================= */
+
+const struct display_driver_s ESCENARIO_DRIVER = {
+    .ScreenTurnOff = ScreenTurnOff,
+    .SegmentsTurnOn = SegmentsTurnOn,
+    .DigitTurnOn = DigitTurnOn,
+};
+
+const struct display_driver_s ESCENARIO_DRIVER_BARRIDO = {
+    .ScreenTurnOff = ScreenTurnOff,
+    .SegmentsTurnOn = SegmentsTurnOn,
+    .DigitTurnOn = DigitTurnOn,
+    .ScanFrames = ScanFrames,
+};
+
+// Pone la hora y la alarma, la cancela, la pospone y la deja sonar con la pantalla apagada
+const char ESCENARIO_GUION_SEMANA[] = "# hora 23:59 y alarma 00:01\n"
+                                      "0 F4\n0 F2\n0 ACEPTAR\n0 F2\n0 ACEPTAR\n"
+                                      "0 F3\n0 F1\n0 ACEPTAR\n0 ACEPTAR\n"
+                                      "120 -       # suena a las 00:01\n"
+                                      "0 CANCELAR\n"
+                                      "86400 -\n"
+                                      "0 ACEPTAR   # se pospone 5 minutos\n"
+                                      "300 -\n"
+                                      "0 CANCELAR\n"
+                                      "3600 F2     # apaga la pantalla\n"
+                                      "82500 -     # la alarma la vuelve a encender\n"
+                                      "0 CANCELAR\n"
+                                      "86400 -\n0 CANCELAR\n86400 -\n0 CANCELAR\n"
+                                      "86400 -\n0 CANCELAR\n86400 -\n0 CANCELAR\n"
+                                      "86400 -\n0 CANCELAR\n";
+
+/* === Private variable definitions ============================================================ */
+
+// Los drivers falsos escriben en variables volatiles para que el compilador no elimine las
+// llamadas, igual que sucede con los registros de GPIO en el hardware real.
+static volatile uint8_t puerto_segmentos;
+static volatile uint8_t puerto_digitos;
+static volatile uint32_t disparos;
+
+// Imagenes entregadas al barrido, con las que se compara la salida emulada
+static uint8_t esperado_on[BARRIDO_MAX_PASOS];
+static uint8_t esperado_off[BARRIDO_MAX_PASOS];
+
+// Disparos registrados por EscenarioSemana: alarma y hora en que sono cada una
+static uint32_t * registro_actual;
+static int registrados;
+
+/* === Private function implementation ========================================================= */
+
+static void ScreenTurnOff(void) {
+    puerto_segmentos = 0;
+    puerto_digitos = 0;
+}
+
+static void SegmentsTurnOn(uint8_t segments) {
+    puerto_segmentos = segments;
+}
+
+static void DigitTurnOn(uint8_t digit) {
+    puerto_digitos = 1 << digit;
+}
+
+static void ScanFrames(const uint8_t * frame_on, const uint8_t * frame_off, uint8_t digits,
+                       uint16_t flashing_steps) {
+    static barrido_paso_t on[BARRIDO_MAX_PASOS];
+    static barrido_paso_t off[BARRIDO_MAX_PASOS];
+
+    for (int i = 0; i < digits; i++) {
+        on[i][0] = off[i][0] = 1 << i;
+        on[i][2] = frame_on[i];
+        off[i][2] = frame_off[i];
+    }
+    memcpy(esperado_on, frame_on, digits);
+    memcpy(esperado_off, frame_off, digits);
+    BarridoCargar(on, off, digits, flashing_steps);
+}
+
+static void Registrar(reloj_t reloj, bool act_desact) {
+    uint8_t hora[6];
+
+    if (act_desact && registrados < ESCENARIO_MAX_REGISTRO) {
+        GetClockTime(reloj, hora, sizeof(hora));
+        registro_actual[registrados++] = (uint32_t)AlarmaSonando(reloj) << 28 |
+                                         GetClockWeekday(reloj) << 24 | hora[0] << 20 |
+                                         hora[1] << 16 | hora[2] << 12 | hora[3] << 8 |
+                                         hora[4] << 4 | hora[5];
+    }
+}
+
+/* === Public function implementation ========================================================== */
+
+double EscenarioAhora(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+void EscenarioDisparar(reloj_t reloj, bool act_desact) {
+    (void)reloj;
+    if (act_desact) {
+        disparos++;
+    }
+}
+
+bool EscenarioPasoValido(const uint32_t * puertos) {
+    int digito = __builtin_ctz(puertos[0] | 0x100);
+
+    return digito < 4 && (puertos[2] == esperado_on[digito] || puertos[2] == esperado_off[digito]);
+}
+
+int EscenarioSemana(bool de_una_vez, uint32_t * registro) {
+    reloj_t reloj = ClockCreate(1, Registrar);
+
+    registro_actual = registro;
+    registrados = 0;
+    SetClockTime(reloj, (uint8_t[]){2, 3, 5, 9, 3, 0}, 6);
+    SetClockWeekday(reloj, 5);
+    AgregarAlarma(reloj, &(struct alarma_config_s){.hora = {0, 0, 0, 0}, .repetir = true});
+    AgregarAlarma(reloj, &(struct alarma_config_s){
+                             .hora = {0, 7, 3, 0},
+                             .dias = ALARMA_LUNES | ALARMA_VIERNES,
+                             .repetir = true,
+                         });
+    AgregarAlarma(reloj, &(struct alarma_config_s){.hora = {1, 2, 0, 0}, .repetir = false});
+    if (de_una_vez) {
+        RelojAdvance(reloj, SEGUNDOS_SEMANA);
+    } else {
+        for (uint32_t s = 0; s < SEGUNDOS_SEMANA; s++) {
+            RelojAdvance(reloj, 1);
+        }
+    }
+    Registrar(reloj, true); // la hora final tambien tiene que coincidir
+    return registrados;
+}
+
+int EscenarioGuion(const char * texto, modos_t * modos, uint8_t hora[6]) {
+    static simulacion_paso_t guion[MAX_PASOS_GUION];
+    int pasos = SimulacionLeerGuion(texto, guion, MAX_PASOS_GUION);
+    reloj_t reloj = ClockCreateFromSource(FUENTE_SIMULADA, SimulacionAlarma);
+    int alarmas;
+
+    *modos = ModosCrear(reloj, DisplayCreate(4, &ESCENARIO_DRIVER));
+    alarmas = SimulacionEjecutar(*modos, reloj, guion, pasos);
+    GetClockTime(reloj, hora, 6);
+    return pasos < 0 ? -1 : alarmas;
+}
+
+// El CRC se verifica codificando de nuevo el mensaje y comparando con la trama
+int EscenarioDecodificar(const uint8_t * trama, int largo, uint8_t * datos) {
+    static uint8_t copia[PROTOCOLO_LARGO_CODIFICADO(PROTOCOLO_MAX_TRAMA)];
+    int decodificados = 0;
+    int codigo;
+
+    if (largo < 2 || trama[0] != 0 || trama[largo - 1] != 0) {
+        return -1;
+    }
+    for (int i = 1; i < largo - 1;) {
+        codigo = trama[i++];
+        for (int j = 1; j < codigo && i < largo - 1; j++) {
+            datos[decodificados++] = trama[i++];
+        }
+        if (codigo < 0xFF && i < largo - 1) {
+            datos[decodificados++] = 0;
+        }
+    }
+    decodificados -= 2;
+    if (decodificados < 0 || ProtocoloCodificar(datos, decodificados, copia) != largo ||
+        memcmp(copia, trama, largo)) {
+        return -1;
+    }
+    return decodificados;
+}
+
+int EscenarioPedir(protocolo_t protocolo, uint8_t * pedido, int largo, uint8_t * respuesta) {
+    static uint8_t trama[PROTOCOLO_LARGO_CODIFICADO(PROTOCOLO_MAX_TRAMA)];
+    protocolo_recepcion_t recepcion = PROTOCOLO_TEXTO;
+    const uint8_t * salida;
+
+    largo = ProtocoloCodificar(pedido, largo, trama);
+    for (int i = 0; i < largo; i++) {
+        recepcion = ProtocoloRecibir(protocolo, trama[i]);
+    }
+    if (recepcion != PROTOCOLO_PEDIDO || !ProtocoloEjecutar(protocolo)) {
+        return -1;
+    }
+    largo = ProtocoloRespuesta(protocolo, &salida);
+    largo = EscenarioDecodificar(salida, largo, respuesta);
+    ProtocoloLiberar(protocolo);
+    return largo;
+}
+
+int EscenarioRecibir(int extremo, uint8_t * datos, int largo) {
+    double limite = EscenarioAhora() + 1e9;
+    int recibidos = 0;
+    ssize_t leidos;
+
+    while (recibidos < largo && EscenarioAhora() < limite) {
+        if (poll(&(struct pollfd){.fd = extremo, .events = POLLIN}, 1, 10) > 0) {
+            leidos = read(extremo, &datos[recibidos], largo - recibidos);
+            if (leidos > 0) {
+                recibidos += leidos;
+            }
+        }
+    }
+    return recibidos;
+}
+
+void EscenarioEco(hal_sci_t sci, sci_status_t status, void * object) {
+    uint8_t datos[16];
+    uint16_t largo;
+
+    (void)object;
+    while (status->data_ready && (largo = SciReceiveData(sci, datos, sizeof(datos)))) {
+        SciSendData(sci, datos, largo);
+    }
+}
+
+/* === End of documentation ==================================================================== */
+
+/** @} End of module definition for doxygen */
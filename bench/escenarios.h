@@ -0,0 +1,128 @@
+/************************************************************************************************
+Copyright (c) 2023, Emiliano Arnedo <emiarnedo@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#ifndef ESCENARIOS_H
+#define ESCENARIOS_H
+
+/** \brief Escenarios de host compartidos por los benchmarks y las pruebas
+ **
+ ** Drivers de pantalla falsos, una semana de alarmas, el guion de una semana de teclas, pedidos
+ ** completos del protocolo remoto y el otro extremo de los puertos serie emulados. Los benchmarks
+ ** los miden y las pruebas verifican su resultado.
+ **
+ ** \addtogroup bench Benchmarks
+ ** @{ */
+
+/* === Headers files inclusions ================================================================ */
+
+#include "reloj.h"
+#include "pantalla.h"
+#include "modos.h"
+#include "protocolo.h"
+#include "soc_sci.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* === Cabecera C++ ============================================================================ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#define ESCENARIO_MAX_REGISTRO 32 // disparos que registra EscenarioSemana
+
+/* === Public data type declarations =========================================================== */
+
+/* === Public variable declarations ============================================================ */
+
+//! Driver de pantalla que escribe en variables volatiles en lugar de los puertos
+extern const struct display_driver_s ESCENARIO_DRIVER;
+
+//! El mismo driver con barrido por hardware: digito en GPIO0 y segmentos en GPIO2, como la placa
+extern const struct display_driver_s ESCENARIO_DRIVER_BARRIDO;
+
+//! Una semana de uso con teclas, con 9 alarmas, que termina a las 00:01 del octavo dia
+extern const char ESCENARIO_GUION_SEMANA[];
+
+/* === Public function declarations ============================================================ */
+
+//! Instante del reloj monotonico del sistema, en nanosegundos
+double EscenarioAhora(void);
+
+//! Funcion de disparo que solo cuenta las alarmas
+void EscenarioDisparar(reloj_t reloj, bool act_desact);
+
+/**
+ * @brief Indica si una salida del barrido emulado muestra alguna de las dos imagenes cargadas
+ * por ESCENARIO_DRIVER_BARRIDO
+ */
+bool EscenarioPasoValido(const uint32_t * puertos);
+
+/**
+ * @brief Una semana de reloj con alarmas repetidas, de algunos dias y de una sola vez
+ *
+ * @param de_una_vez avanza la semana con una sola llamada en lugar de hacerlo de a un segundo
+ * @param registro alarma, dia y hora de cada disparo, y al final la hora en que termino
+ * @return int cantidad de entradas del registro, como mucho ESCENARIO_MAX_REGISTRO
+ */
+int EscenarioSemana(bool de_una_vez, uint32_t * registro);
+
+/**
+ * @brief Recorre un guion con un reloj nuevo, sin hora, sobre la fuente simulada detenida
+ *
+ * @return int cantidad de alarmas que sonaron, o -1 si el guion tiene errores
+ */
+int EscenarioGuion(const char * texto, modos_t * modos, uint8_t hora[6]);
+
+/**
+ * @brief Deshace el COBS de una trama con sus delimitadores y verifica el CRC
+ *
+ * @return int largo del mensaje sin el CRC, o -1 si la trama no es valida
+ */
+int EscenarioDecodificar(const uint8_t * trama, int largo, uint8_t * datos);
+
+/**
+ * @brief Hace con un pedido lo mismo que la interrupcion de la consola, ClockTask y
+ * DiagnosticTask: lo recibe byte por byte, lo ejecuta y toma la respuesta
+ *
+ * @param pedido mensaje con dos bytes libres al final para el CRC
+ * @return int largo de la respuesta, o -1 si el pedido no se completo
+ */
+int EscenarioPedir(protocolo_t protocolo, uint8_t * pedido, int largo, uint8_t * respuesta);
+
+/**
+ * @brief Lee del otro extremo de una linea emulada hasta completar el largo o hasta que pasa un
+ * segundo
+ *
+ * @return int cantidad de bytes leidos
+ */
+int EscenarioRecibir(int extremo, uint8_t * datos, int largo);
+
+//! Manejador de eventos que devuelve por el mismo puerto cada byte que llega
+void EscenarioEco(hal_sci_t sci, sci_status_t status, void * object);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} End of module definition for doxygen */
+
+#endif /* ESCENARIOS_H */
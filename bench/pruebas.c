@@ -0,0 +1,543 @@
+/************************************************************************************************
+Copyright (c) 2023, Emiliano Arnedo <emiarnedo@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** \brief Pruebas de comportamiento de los modulos portables en el host
+ **
+ ** Cada prueba arma su propio escenario y verifica un comportamiento: las transiciones de la
+ ** interfaz, la lectura concurrente de la hora, el barrido emulado, las fuentes de tiempo, el
+ ** protocolo remoto y los puertos serie emulados. Imprime una linea por prueba y termina con 1 si
+ ** alguna falla.
+ **
+ ** Uso: pruebas.out
+ **
+ ** \addtogroup bench Benchmarks
+ ** @{ */
+
+/* === Headers files inclusions =============================================================== */
+
+#include "escenarios.h"
+#include "barrido.h"
+#include "tiempo.h"
+#include "diagnostico.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/* === Macros definitions ====================================================================== */
+
+#define CAMBIOS_HORA    1000000 // veces que se cambia la hora mientras otro hilo la lee
+#define PERIODO_BARRIDO 100     // microsegundos por paso en la emulacion del barrido
+#define LARGO_BLOQUE    3000    // bytes del bloque que se envia por el puerto serie emulado
+#define LARGO_TRAFICO   2000    // bytes que se envian a 115200 baudios por el anillo
+#define LARGO_ANILLO    256     // bytes del anillo de transmision del puerto serie emulado
+#define ECOS            100     // bytes que van y vuelven por el puerto serie emulado
+
+/* === Private data type declarations ========================================================== */
+
+//! Paso de una traza: evento que se inyecta y modo en que tiene que quedar la maquina de estados
+typedef struct paso_traza_s {
+    evento_t evento;
+    modo_t modo;
+} paso_traza_s;
+
+typedef struct prueba_s {
+    const char * nombre;
+    bool (*Probar)(void);
+} prueba_s;
+
+/* === Private variable declarations =========================================================== */
+
+/* === Private function declarations =========================================================== */
+
+static bool ReproducirTraza(modos_t modos, const char * nombre, const paso_traza_s * traza,
+                            size_t pasos);
+static void * LeerHora(void * reloj);
+static void ObservarBarrido(const uint32_t * puertos);
+static void EventoSerie(hal_sci_t sci, sci_status_t status, void * object);
+static protocolo_t CrearProtocolo(reloj_t * reloj, modos_t * modos);
+static bool Configurar(protocolo_t protocolo);
+
+static bool PruebaTransiciones(void);
+static bool PruebaLecturaConcurrente(void);
+static bool PruebaBarridoEmulado(void);
+static bool PruebaFuenteMonotonica(void);
+static bool PruebaAvanzarSemana(void);
+static bool PruebaGuionSemana(void);
+static bool PruebaProtocoloConfigurar(void);
+static bool PruebaProtocoloListar(void);
+static bool PruebaProtocoloValorErroneo(void);
+static bool PruebaProtocoloTramaErronea(void);
+static bool PruebaProtocoloPedidoPendiente(void);
+static bool PruebaSciBloque(void);
+static bool PruebaSciTrafico(void);
+static bool PruebaSciEco(void);
+
+/* === Public variable definitions ============================================================= */
+
+/* === Private variable definitions ============================================================ */
+
+// Trazas de eventos de la interfaz que se reproducen contra la tabla de transiciones
+static const paso_traza_s TRAZA_SIN_HORA[] = {
+    {EVENTO_ACEPTAR, SIN_CONFIGURAR},
+    {EVENTO_F4, AJUSTANDO_MINUTOS_ACTUAL},
+    {EVENTO_CANCELAR, SIN_CONFIGURAR}, // sin hora valida vuelve a sin configurar
+};
+
+static const paso_traza_s TRAZA_AJUSTE_HORA[] = {
+    {EVENTO_F4, AJUSTANDO_MINUTOS_ACTUAL}, {EVENTO_F1, AJUSTANDO_MINUTOS_ACTUAL},
+    {EVENTO_F2, AJUSTANDO_MINUTOS_ACTUAL}, {EVENTO_ACEPTAR, AJUSTANDO_HORAS_ACTUAL},
+    {EVENTO_CANCELAR, AJUSTANDO_MINUTOS_ACTUAL}, {EVENTO_ACEPTAR, AJUSTANDO_HORAS_ACTUAL},
+    {EVENTO_F1, AJUSTANDO_HORAS_ACTUAL}, {EVENTO_ACEPTAR, MOSTRANDO_HORA},
+    {EVENTO_F1, MOSTRANDO_HORA}, {EVENTO_F4, AJUSTANDO_MINUTOS_ACTUAL},
+    {EVENTO_CANCELAR, MOSTRANDO_HORA}, // con hora valida vuelve a mostrarla
+};
+
+static const paso_traza_s TRAZA_ALARMA[] = {
+    {EVENTO_F3, AJUSTANDO_MINUTOS_ALARMA}, {EVENTO_F1, AJUSTANDO_MINUTOS_ALARMA},
+    {EVENTO_ACEPTAR, AJUSTANDO_HORAS_ALARMA}, {EVENTO_F3, AJUSTANDO_MINUTOS_ALARMA},
+    {EVENTO_ACEPTAR, AJUSTANDO_HORAS_ALARMA}, {EVENTO_ACEPTAR, MOSTRANDO_HORA},
+    {EVENTO_CANCELAR, MOSTRANDO_HORA}, {EVENTO_ACEPTAR, MOSTRANDO_HORA},
+    {EVENTO_ALARMA_SONANDO, MOSTRANDO_HORA}, {EVENTO_ACEPTAR, MOSTRANDO_HORA},
+    {EVENTO_ALARMA_CALLADA, MOSTRANDO_HORA}, {EVENTO_ALARMA_SONANDO, MOSTRANDO_HORA},
+    {EVENTO_CANCELAR, MOSTRANDO_HORA},
+};
+
+static const paso_traza_s TRAZA_PANTALLA_APAGADA[] = {
+    {EVENTO_F2, PANTALLA_APAGADA},
+    {EVENTO_F4, MOSTRANDO_HORA}, // con la pantalla apagada la tecla solo la enciende
+    {EVENTO_F2, PANTALLA_APAGADA},
+    {EVENTO_ALARMA_CALLADA, PANTALLA_APAGADA},
+    {EVENTO_ALARMA_SONANDO, MOSTRANDO_HORA},
+    {EVENTO_CANCELAR, MOSTRANDO_HORA},
+};
+
+static const prueba_s PRUEBAS[] = {
+    {"transiciones", PruebaTransiciones},
+    {"lectura_concurrente", PruebaLecturaConcurrente},
+    {"barrido_emulado", PruebaBarridoEmulado},
+    {"fuente_monotonica", PruebaFuenteMonotonica},
+    {"avanzar_semana", PruebaAvanzarSemana},
+    {"guion_semana", PruebaGuionSemana},
+    {"protocolo_configurar", PruebaProtocoloConfigurar},
+    {"protocolo_listar", PruebaProtocoloListar},
+    {"protocolo_valor_erroneo", PruebaProtocoloValorErroneo},
+    {"protocolo_trama_erronea", PruebaProtocoloTramaErronea},
+    {"protocolo_pedido_pendiente", PruebaProtocoloPedidoPendiente},
+    {"sci_bloque", PruebaSciBloque},
+    {"sci_trafico", PruebaSciTrafico},
+    {"sci_eco", PruebaSciEco},
+};
+
+// Lecturas de la hora desde otro hilo mientras la prueba la cambia entre dos valores
+static volatile bool leyendo;
+static volatile uint32_t lecturas;
+static volatile uint32_t lecturas_rotas;
+
+// Pasos de la salida del barrido emulado y cuantos no mostraban ninguna de las imagenes
+static volatile uint32_t pasos_observados;
+static volatile uint32_t pasos_erroneos;
+
+// Fines de bloque que informo el puerto serie emulado
+static volatile uint32_t bloques_enviados;
+
+// Mensaje del pedido de estado, con dos bytes libres para el CRC
+static uint8_t estado[] = {PROTOCOLO_LEER_ESTADO, 4, 0, 0};
+
+/* === Private function implementation ========================================================= */
+
+static bool ReproducirTraza(modos_t modos, const char * nombre, const paso_traza_s * traza,
+                            size_t pasos) {
+    for (size_t i = 0; i < pasos; i++) {
+        modo_t modo = ModosProcesar(modos, traza[i].evento);
+        if (modo != traza[i].modo) {
+            fprintf(stderr, "prueba: traza %s, paso %zu: modo %d, se esperaba %d\n", nombre, i,
+                    modo, traza[i].modo);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Toda lectura tiene que ser una de las dos horas que escribe la prueba, nunca una mezcla
+static void * LeerHora(void * reloj) {
+    uint8_t hora[6];
+
+    while (leyendo) {
+        GetClockTime(reloj, hora, sizeof(hora));
+        if (memcmp(hora, (uint8_t[]){1, 9, 5, 9, 5, 9}, 6) &&
+            memcmp(hora, (uint8_t[]){2, 0, 0, 0, 0, 0}, 6)) {
+            lecturas_rotas++;
+        }
+        lecturas++;
+    }
+    return NULL;
+}
+
+static void ObservarBarrido(const uint32_t * puertos) {
+    pasos_observados++;
+    if (!EscenarioPasoValido(puertos)) {
+        pasos_erroneos++;
+    }
+}
+
+static void EventoSerie(hal_sci_t sci, sci_status_t status, void * object) {
+    (void)sci;
+    (void)object;
+    if (status->block_sent) {
+        bloques_enviados++;
+    }
+}
+
+// Un reloj y unos modos sin configurar, con el protocolo remoto sobre ellos
+static protocolo_t CrearProtocolo(reloj_t * reloj, modos_t * modos) {
+    *reloj = ClockCreate(TICKS_PER_SECOND, EscenarioDisparar);
+    *modos = ModosCrear(*reloj, DisplayCreate(4, &ESCENARIO_DRIVER));
+    return ProtocoloCrear(*reloj, *modos);
+}
+
+// La configuracion completa de un reloj nuevo en un solo pedido: hora, dia y dos alarmas
+static bool Configurar(protocolo_t protocolo) {
+    static uint8_t respuesta[PROTOCOLO_MAX_TRAMA];
+    uint8_t configurar[] = {PROTOCOLO_CONFIGURAR, 1, 0x07, 0x30, 0x00, 2,
+                            0x06, 0x45, ALARMA_LUNES | ALARMA_VIERNES, PROTOCOLO_REPETIR,
+                            0x22, 0x00, 0, 0, 0, 0};
+
+    return EscenarioPedir(protocolo, configurar, sizeof(configurar) - 2, respuesta) == 5 &&
+           !memcmp(respuesta, (uint8_t[]){0x86, 1, PROTOCOLO_OK, 0, 1}, 5);
+}
+
+// Las trazas se reproducen en orden sobre el mismo reloj, empezando sin hora valida
+static bool PruebaTransiciones(void) {
+    reloj_t reloj = ClockCreate(TICKS_PER_SECOND, EscenarioDisparar);
+    modos_t modos = ModosCrear(reloj, DisplayCreate(4, &ESCENARIO_DRIVER));
+
+    return ReproducirTraza(modos, "sin_hora", TRAZA_SIN_HORA,
+                           sizeof(TRAZA_SIN_HORA) / sizeof(TRAZA_SIN_HORA[0])) &&
+           ReproducirTraza(modos, "ajuste_hora", TRAZA_AJUSTE_HORA,
+                           sizeof(TRAZA_AJUSTE_HORA) / sizeof(TRAZA_AJUSTE_HORA[0])) &&
+           ReproducirTraza(modos, "alarma", TRAZA_ALARMA,
+                           sizeof(TRAZA_ALARMA) / sizeof(TRAZA_ALARMA[0])) &&
+           ReproducirTraza(modos, "pantalla_apagada", TRAZA_PANTALLA_APAGADA,
+                           sizeof(TRAZA_PANTALLA_APAGADA) / sizeof(TRAZA_PANTALLA_APAGADA[0]));
+}
+
+// Otro hilo lee la hora sin sincronizarse mientras aca se la cambia todo el tiempo
+static bool PruebaLecturaConcurrente(void) {
+    reloj_t reloj = ClockCreate(TICKS_PER_SECOND, EscenarioDisparar);
+    pthread_t lector;
+
+    SetClockTime(reloj, (uint8_t[]){1, 9, 5, 9, 5, 9}, 6);
+    leyendo = true;
+    pthread_create(&lector, NULL, LeerHora, reloj);
+    for (long i = 1; i <= CAMBIOS_HORA || lecturas == 0; i++) {
+        SetClockTime(reloj, (i & 1) ? (uint8_t[]){2, 0, 0, 0, 0, 0} : (uint8_t[]){1, 9, 5, 9, 5, 9},
+                     6);
+    }
+    leyendo = false;
+    pthread_join(lector, NULL);
+    if (lecturas_rotas) {
+        fprintf(stderr, "prueba: %u de %u lecturas concurrentes de la hora inconsistentes\n",
+                (unsigned)lecturas_rotas, (unsigned)lecturas);
+        return false;
+    }
+    return true;
+}
+
+// La salida emulada solo puede mostrar alguna de las dos imagenes cargadas
+static bool PruebaBarridoEmulado(void) {
+    display_t display;
+
+    BarridoIniciar(PERIODO_BARRIDO, (const uint32_t[BARRIDO_PUERTOS]){[0] = 0x0F, [2] = 0xFF});
+    display = DisplayCreate(4, &ESCENARIO_DRIVER_BARRIDO);
+    DisplayFlashDigits(display, 0, 1, 250);
+    DisplayWriteBCD(display, (uint8_t[]){1, 2, 3, 4}, 4);
+    BarridoObservar(ObservarBarrido);
+    nanosleep(&(struct timespec){.tv_nsec = 200 * PERIODO_BARRIDO * 1000}, NULL);
+    BarridoObservar(NULL);
+    if (pasos_observados == 0 || pasos_erroneos) {
+        fprintf(stderr, "prueba: barrido emulado con %u pasos erroneos de %u\n",
+                (unsigned)pasos_erroneos, (unsigned)pasos_observados);
+        return false;
+    }
+    return true;
+}
+
+// La hora de un reloj sobre el reloj monotonico del sistema avanza con el tiempo real
+static bool PruebaFuenteMonotonica(void) {
+    reloj_t reloj = ClockCreateFromSource(FUENTE_MONOTONICA, EscenarioDisparar);
+    uint8_t hora[6];
+
+    SetClockTime(reloj, (uint8_t[]){1, 2, 0, 0, 0, 0}, 6);
+    nanosleep(&(struct timespec){.tv_sec = 1, .tv_nsec = 100000000}, NULL);
+    ClockUpdate(reloj);
+    GetClockTime(reloj, hora, sizeof(hora));
+    if (hora[4] * 10 + hora[5] < 1) {
+        fprintf(stderr, "prueba: el reloj sobre la fuente monotonica no avanzo\n");
+        return false;
+    }
+    return true;
+}
+
+// Avanzar una semana de una vez dispara las mismas alarmas, en el mismo orden y a la misma hora,
+// que avanzar de a un segundo
+static bool PruebaAvanzarSemana(void) {
+    static uint32_t por_segundo[ESCENARIO_MAX_REGISTRO], de_una_vez[ESCENARIO_MAX_REGISTRO];
+    int cantidad = EscenarioSemana(false, por_segundo);
+
+    if (EscenarioSemana(true, de_una_vez) != cantidad ||
+        memcmp(por_segundo, de_una_vez, cantidad * sizeof(uint32_t))) {
+        fprintf(stderr, "prueba: RelojAdvance disparo distinto que avanzar de a un segundo\n");
+        return false;
+    }
+    return true;
+}
+
+// Una semana de teclas y alarmas con el tiempo simulado
+static bool PruebaGuionSemana(void) {
+    modos_t modos;
+    uint8_t hora[6];
+    int alarmas = EscenarioGuion(ESCENARIO_GUION_SEMANA, &modos, hora);
+
+    if (alarmas != 9 || ModosActual(modos) != MOSTRANDO_HORA ||
+        memcmp(hora, (uint8_t[]){0, 0, 0, 1, 0, 0}, sizeof(hora))) {
+        fprintf(stderr, "prueba: la semana simulada termino a las %u%u:%u%u:%u%u con %d alarmas\n",
+                hora[0], hora[1], hora[2], hora[3], hora[4], hora[5], alarmas);
+        return false;
+    }
+    return true;
+}
+
+// Un solo pedido deja el reloj con hora, dia y la interfaz mostrando la hora
+static bool PruebaProtocoloConfigurar(void) {
+    reloj_t reloj;
+    modos_t modos;
+    protocolo_t protocolo = CrearProtocolo(&reloj, &modos);
+    uint8_t hora[6];
+
+    if (ProtocoloRecibir(protocolo, DIAGNOSTICO_COMANDO) != PROTOCOLO_TEXTO ||
+        !Configurar(protocolo) || ModosActual(modos) != MOSTRANDO_HORA ||
+        !GetClockTime(reloj, hora, sizeof(hora)) ||
+        memcmp(hora, (uint8_t[]){0, 7, 3, 0, 0, 0}, sizeof(hora)) || GetClockWeekday(reloj) != 2) {
+        fprintf(stderr, "prueba: el protocolo no configuro el reloj\n");
+        return false;
+    }
+    return true;
+}
+
+// La lista de alarmas muestra las que dejo la configuracion, programadas
+static bool PruebaProtocoloListar(void) {
+    static uint8_t respuesta[PROTOCOLO_MAX_TRAMA];
+    uint8_t listar[] = {PROTOCOLO_LISTAR_ALARMAS, 2, 0, 0};
+    reloj_t reloj;
+    modos_t modos;
+    protocolo_t protocolo = CrearProtocolo(&reloj, &modos);
+
+    if (!Configurar(protocolo) ||
+        EscenarioPedir(protocolo, listar, sizeof(listar) - 2, respuesta) != 13 ||
+        memcmp(&respuesta[3],
+               (uint8_t[]){0, 0x06, 0x45, ALARMA_LUNES | ALARMA_VIERNES,
+                           PROTOCOLO_REPETIR | PROTOCOLO_PROGRAMADA, 1, 0x22, 0x00,
+                           ALARMA_TODOS_LOS_DIAS, PROTOCOLO_PROGRAMADA},
+               10)) {
+        fprintf(stderr, "prueba: el protocolo no listo las alarmas configuradas\n");
+        return false;
+    }
+    return true;
+}
+
+static bool PruebaProtocoloValorErroneo(void) {
+    static uint8_t respuesta[PROTOCOLO_MAX_TRAMA];
+    uint8_t erroneo[] = {PROTOCOLO_FIJAR_HORA, 3, 0x24, 0x00, 0x00, 0, 0};
+    reloj_t reloj;
+    modos_t modos;
+    protocolo_t protocolo = CrearProtocolo(&reloj, &modos);
+
+    if (EscenarioPedir(protocolo, erroneo, sizeof(erroneo) - 2, respuesta) != 3 ||
+        respuesta[2] != PROTOCOLO_VALOR_ERRONEO) {
+        fprintf(stderr, "prueba: el protocolo acepto una hora invalida\n");
+        return false;
+    }
+    return true;
+}
+
+// Un byte cambiado en la trama no llega a ser un pedido y se cuenta como descartado
+static bool PruebaProtocoloTramaErronea(void) {
+    static uint8_t trama[PROTOCOLO_LARGO_CODIFICADO(sizeof(estado))];
+    int largo = ProtocoloCodificar(estado, sizeof(estado) - 2, trama);
+    protocolo_recepcion_t recepcion = PROTOCOLO_TEXTO;
+    reloj_t reloj;
+    modos_t modos;
+    protocolo_t protocolo = CrearProtocolo(&reloj, &modos);
+
+    trama[2] ^= 0x10;
+    for (int i = 0; i < largo; i++) {
+        recepcion = ProtocoloRecibir(protocolo, trama[i]);
+    }
+    if (recepcion != PROTOCOLO_TRAMA || *ProtocoloDescartadas(protocolo) != 1) {
+        fprintf(stderr, "prueba: el protocolo no descarto una trama con error de CRC\n");
+        return false;
+    }
+    return true;
+}
+
+// Un pedido pendiente no se pierde por el delimitador de la trama siguiente ni por ruido
+static bool PruebaProtocoloPedidoPendiente(void) {
+    static uint8_t trama[PROTOCOLO_LARGO_CODIFICADO(sizeof(estado))];
+    static uint8_t respuesta[PROTOCOLO_MAX_TRAMA];
+    int largo = ProtocoloCodificar(estado, sizeof(estado) - 2, trama);
+    protocolo_recepcion_t recepcion = PROTOCOLO_TEXTO;
+    const uint8_t * salida = NULL;
+    reloj_t reloj;
+    modos_t modos;
+    protocolo_t protocolo = CrearProtocolo(&reloj, &modos);
+
+    for (int i = 0; i < largo; i++) {
+        recepcion = ProtocoloRecibir(protocolo, trama[i]);
+    }
+    ProtocoloRecibir(protocolo, 0);
+    ProtocoloRecibir(protocolo, 0x55);
+    ProtocoloRecibir(protocolo, 0);
+    largo = ProtocoloEjecutar(protocolo) ? ProtocoloRespuesta(protocolo, &salida) : 0;
+    if (recepcion != PROTOCOLO_PEDIDO || EscenarioDecodificar(salida, largo, respuesta) != 11 ||
+        respuesta[2] != PROTOCOLO_OK) {
+        fprintf(stderr, "prueba: el protocolo perdio un pedido pendiente al recibir otra trama\n");
+        return false;
+    }
+    ProtocoloLiberar(protocolo);
+    return true;
+}
+
+// Un bloque sale por el puerto serie emulado sin copiarse, llega entero al otro extremo de la
+// linea y su fin se avisa por el manejador de eventos
+static bool PruebaSciBloque(void) {
+    static uint8_t bloque[LARGO_BLOQUE], recibido[LARGO_BLOQUE];
+    bool correcto = true;
+    double inicio;
+
+    for (int i = 0; i < LARGO_BLOQUE; i++) {
+        bloque[i] = i * 7;
+    }
+    if (!SciSetConfig(HAL_SCI_POSIX0, NULL, NULL)) {
+        fprintf(stderr, "prueba: no se pudo crear la linea del puerto serie emulado\n");
+        return false;
+    }
+    SciSetEventHandler(HAL_SCI_POSIX0, EventoSerie, NULL);
+    if (SciSendBlock(HAL_SCI_POSIX0, bloque, LARGO_BLOQUE) != LARGO_BLOQUE ||
+        EscenarioRecibir(SciPosixPeer(HAL_SCI_POSIX0), recibido, LARGO_BLOQUE) != LARGO_BLOQUE ||
+        memcmp(bloque, recibido, LARGO_BLOQUE)) {
+        fprintf(stderr, "prueba: el bloque no llego entero por el puerto serie emulado\n");
+        correcto = false;
+    }
+    for (inicio = EscenarioAhora(); bloques_enviados == 0 && EscenarioAhora() < inicio + 1e9;) {
+    }
+    if (bloques_enviados != 1) {
+        fprintf(stderr, "prueba: el puerto serie emulado aviso %u fines de bloque\n",
+                (unsigned)bloques_enviados);
+        correcto = false;
+    }
+    SciSetEventHandler(HAL_SCI_POSIX0, NULL, NULL);
+    return correcto;
+}
+
+// Lo que pasa por el anillo de transmision a 115200 baudios llega entero y en orden
+static bool PruebaSciTrafico(void) {
+    static uint8_t anillo[LARGO_ANILLO], trafico[LARGO_TRAFICO], recibido[LARGO_TRAFICO];
+    int enviados = 0;
+
+    for (int i = 0; i < LARGO_TRAFICO; i++) {
+        trafico[i] = i * 13;
+    }
+    if (!SciSetConfig(HAL_SCI_POSIX1,
+                      &(struct hal_sci_line_s){
+                          .baud_rate = 115200,
+                          .data_bits = 8,
+                          .parity = HAL_SCI_NO_PARITY,
+                      },
+                      NULL) ||
+        !SciSetBuffers(HAL_SCI_POSIX1, &(struct hal_sci_buffers_s){
+                                           .tx_data = anillo,
+                                           .tx_size = sizeof(anillo),
+                                           .tx_low_water = sizeof(anillo) / 2,
+                                       })) {
+        fprintf(stderr, "prueba: no se pudo configurar el segundo puerto serie emulado\n");
+        return false;
+    }
+    while (enviados < LARGO_TRAFICO) {
+        enviados += SciSendData(HAL_SCI_POSIX1, &trafico[enviados], LARGO_TRAFICO - enviados);
+        if (enviados < LARGO_TRAFICO) {
+            nanosleep(&(struct timespec){.tv_nsec = 1000000}, NULL);
+        }
+    }
+    if (EscenarioRecibir(SciPosixPeer(HAL_SCI_POSIX1), recibido, LARGO_TRAFICO) != LARGO_TRAFICO ||
+        memcmp(trafico, recibido, LARGO_TRAFICO)) {
+        fprintf(stderr, "prueba: el trafico no llego entero por el puerto serie emulado\n");
+        return false;
+    }
+    return true;
+}
+
+// Cada byte que se escribe en el otro extremo vuelve por el eco hecho desde el evento
+static bool PruebaSciEco(void) {
+    int extremo, ecos = 0;
+
+    if (!SciSetConfig(HAL_SCI_POSIX0,
+                      &(struct hal_sci_line_s){
+                          .baud_rate = 115200,
+                          .data_bits = 8,
+                          .parity = HAL_SCI_NO_PARITY,
+                      },
+                      NULL)) {
+        fprintf(stderr, "prueba: no se pudo crear la linea del puerto serie emulado\n");
+        return false;
+    }
+    extremo = SciPosixPeer(HAL_SCI_POSIX0);
+    SciSetEventHandler(HAL_SCI_POSIX0, EscenarioEco, NULL);
+    for (int i = 0; i < ECOS; i++) {
+        uint8_t dato = i;
+        if (write(extremo, &dato, 1) == 1 && EscenarioRecibir(extremo, &dato, 1) == 1 &&
+            dato == i) {
+            ecos++;
+        }
+    }
+    if (ecos != ECOS) {
+        fprintf(stderr, "prueba: volvieron %d de %d ecos por el puerto serie emulado\n", ecos,
+                ECOS);
+        return false;
+    }
+    return true;
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(void) {
+    int fallas = 0;
+
+    for (size_t i = 0; i < sizeof(PRUEBAS) / sizeof(PRUEBAS[0]); i++) {
+        bool correcto = PRUEBAS[i].Probar();
+        printf("%s,%s\n", PRUEBAS[i].nombre, correcto ? "ok" : "falla");
+        if (!correcto) {
+            fallas++;
+        }
+    }
+    return fallas ? 1 : 0;
+}
+
+/* === End of documentation ==================================================================== */
+
+/** @} End of module definition for doxygen */
@@ -0,0 +1,156 @@
+/************************************************************************************************
+Copyright (c) 2023, Emiliano Arnedo <emiarnedo@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** \brief Costo de las senales entre tareas sobre el port posix de FreeRTOS
+ **
+ ** Compara los grupos de eventos con las notificaciones directas a tareas, que son los dos
+ ** caminos posibles entre ClockTask y DisplayTask. Para cada uno mide lo que cuesta enviar una
+ ** senal sin nadie esperando y una ida y vuelta entre dos tareas de la misma prioridad, que
+ ** incluye los cambios de contexto. Corre con el kernel real, con el mismo FreeRTOSConfig.h que la
+ ** placa, y termina el programa al imprimir los resultados.
+ **
+ ** \addtogroup bench Benchmarks
+ ** \brief Benchmarks de los modulos en la PC
+ ** @{ */
+
+/* === Headers files inclusions =============================================================== */
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "event_groups.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* === Macros definitions ====================================================================== */
+
+#define ENVIOS       1000000 // senales sin nadie esperando
+#define IDAS_VUELTAS 20000   // senales con cambio de contexto
+#define PILA         (configMINIMAL_STACK_SIZE * 4)
+#define SENAL_IDA    (1 << 0)
+#define SENAL_VUELTA (1 << 1)
+
+/* === Private data type declarations ========================================================== */
+
+/* === Private variable declarations =========================================================== */
+
+/* === Private function declarations =========================================================== */
+
+static double Ahora(void);
+static void Informar(const char * nombre, long iteraciones, double inicio);
+static void ResponderGrupo(void * object);
+static void ResponderNotificacion(void * object);
+static void Medir(void * object);
+
+/* === Public variable definitions ============================================================= */
+
+/* === Private variable definitions ============================================================ */
+
+static EventGroupHandle_t grupo;
+static TaskHandle_t medidor;
+static TaskHandle_t respondedor;
+
+/* === Private function implementation ========================================================= */
+
+static double Ahora(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Sin referencias: en el port posix los cambios de contexto son cambios de hilo del sistema
+// operativo y varian demasiado entre maquinas para compararlos con un umbral
+static void Informar(const char * nombre, long iteraciones, double inicio) {
+    printf("%s,%ld,%.3f,0.000,-\n", nombre, iteraciones, (Ahora() - inicio) / iteraciones);
+}
+
+static void ResponderGrupo(void * object) {
+    while (true) {
+        xEventGroupWaitBits(grupo, SENAL_IDA, pdTRUE, pdFALSE, portMAX_DELAY);
+        xEventGroupSetBits(grupo, SENAL_VUELTA);
+    }
+}
+
+static void ResponderNotificacion(void * object) {
+    uint32_t valor;
+
+    while (true) {
+        xTaskNotifyWait(0, UINT32_MAX, &valor, portMAX_DELAY);
+        xTaskNotify(medidor, valor, eSetBits);
+    }
+}
+
+static void Medir(void * object) {
+    uint32_t valor;
+    double inicio;
+    long i;
+
+    // Envios sin nadie esperando: solo el costo de la primitiva en la tarea que senala
+    inicio = Ahora();
+    for (i = 0; i < ENVIOS; i++) {
+        xEventGroupSetBits(grupo, SENAL_VUELTA);
+    }
+    Informar("grupo_enviar", i, inicio);
+    xEventGroupClearBits(grupo, SENAL_VUELTA);
+
+    inicio = Ahora();
+    for (i = 0; i < ENVIOS; i++) {
+        xTaskNotify(respondedor, SENAL_IDA, eSetBits);
+    }
+    Informar("notificacion_enviar", i, inicio);
+
+    // Ida y vuelta entre dos tareas: dos senales y dos cambios de contexto por iteracion
+    vTaskDelete(respondedor);
+    xTaskCreate(ResponderGrupo, "Grupo", PILA, NULL, tskIDLE_PRIORITY + 1, &respondedor);
+    inicio = Ahora();
+    for (i = 0; i < IDAS_VUELTAS; i++) {
+        xEventGroupSetBits(grupo, SENAL_IDA);
+        xEventGroupWaitBits(grupo, SENAL_VUELTA, pdTRUE, pdFALSE, portMAX_DELAY);
+    }
+    Informar("grupo_ida_vuelta", i, inicio);
+
+    vTaskDelete(respondedor);
+    xTaskCreate(ResponderNotificacion, "Notificacion", PILA, NULL, tskIDLE_PRIORITY + 1,
+                &respondedor);
+    inicio = Ahora();
+    for (i = 0; i < IDAS_VUELTAS; i++) {
+        xTaskNotify(respondedor, SENAL_IDA, eSetBits);
+        xTaskNotifyWait(0, UINT32_MAX, &valor, portMAX_DELAY);
+    }
+    Informar("notificacion_ida_vuelta", i, inicio);
+
+    fflush(stdout);
+    exit(0);
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(void) {
+    printf("benchmark,iteraciones,ns_op,referencia_ns_op,estado\n");
+    grupo = xEventGroupCreate();
+    // El primer respondedor solo espera al grupo con menos prioridad, asi durante los envios sin
+    // nadie esperando no le llega ninguna senal que lo despierte
+    xTaskCreate(ResponderGrupo, "Grupo", PILA, NULL, tskIDLE_PRIORITY, &respondedor);
+    xTaskCreate(Medir, "Medir", PILA, NULL, tskIDLE_PRIORITY + 1, &medidor);
+    vTaskStartScheduler();
+    return 1;
+}
+
+/* === End of documentation ==================================================================== */
+
+/** @} End of module definition for doxygen */
@@ -27,6 +27,7 @@
 #define FREERTOS_CONFIG_H
 
 #include <board.h>
+#include <stdint.h>
 
 /*-----------------------------------------------------------
  * Application specific definitions.
@@ -42,18 +43,31 @@
 
 /* clang-format off */
 
+// Con STATIC_ALLOCATION las tareas y objetos del kernel se crean con memoria estatica y el heap
+// solo queda para lo que pida el port
+#if defined(STATIC_ALLOCATION)
+#define configSUPPORT_STATIC_ALLOCATION  1
+#define configTOTAL_HEAP_SIZE            ((size_t)(1 * 1024))
+#else
 #define configSUPPORT_STATIC_ALLOCATION  0
+#define configTOTAL_HEAP_SIZE            ((size_t)(16 * 1024)) /* 16 Kbytes. */
+#endif
 
 #define configUSE_PREEMPTION             1
 #define configUSE_IDLE_HOOK              0
+/* Los ports de Cortex-M detienen el SysTick mientras la CPU esta ociosa y corrigen la cuenta de
+ * ticks al despertar. */
+#if defined(POSIX)
 #define configUSE_TICKLESS_IDLE          0
+#else
+#define configUSE_TICKLESS_IDLE          1
+#endif
 #define configUSE_TICK_HOOK              0
 #define configCPU_CLOCK_HZ               (SystemCoreClock)
 #define configTICK_RATE_HZ               ((TickType_t)1000) // 1000 ticks per second => 1ms tick rate
 #define configMAX_PRIORITIES             (15)
 #define configMINIMAL_STACK_SIZE         ((uint16_t)128)
 #define configAPPLICATION_ALLOCATED_HEAP 0
-#define configTOTAL_HEAP_SIZE            ((size_t)(16 * 1024)) /* 16 Kbytes. */
 #define configMAX_TASK_NAME_LEN          (16)
 #define configUSE_TRACE_FACILITY         1
 #define configUSE_16_BIT_TICKS           0
@@ -65,7 +79,21 @@
 #define configUSE_MALLOC_FAILED_HOOK     0
 #define configUSE_APPLICATION_TASK_TAG   0
 #define configUSE_COUNTING_SEMAPHORES    1
-#define configGENERATE_RUN_TIME_STATS    0
+#define configGENERATE_RUN_TIME_STATS    1
+/* En el indice 1 src/diagnostico.c espera que haya lugar en el anillo de salida de la consola. */
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES 2
+
+/* Estadisticas de ejecucion, que src/diagnostico.c informa por la consola serie. En la placa el
+ * contador es un timer libre de 1 MHz. Se cuentan los cambios de contexto de cada tarea. */
+void DiagnosticoIniciarContador(void);
+uint32_t DiagnosticoContador(void);
+void DiagnosticoTareaEntrando(uint32_t numero);
+#if !defined(POSIX)
+/* El port posix ya tiene su propio contador de tiempo de ejecucion. */
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() DiagnosticoIniciarContador()
+#define portGET_RUN_TIME_COUNTER_VALUE()         DiagnosticoContador()
+#endif
+#define traceTASK_SWITCHED_IN()                  DiagnosticoTareaEntrando(pxCurrentTCB->uxTCBNumber)
 
 /* Co-routine definitions. */
 #define configUSE_CO_ROUTINES           0
@@ -0,0 +1,98 @@
+/************************************************************************************************
+Copyright (c) 2023, Emiliano Arnedo <emiarnedo@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#ifndef BARRIDO_H
+#define BARRIDO_H
+
+/** \brief Barrido de la pantalla por hardware
+ **
+ ** Recorre una tabla de pasos precalculada, escribiendo en cada paso un valor en cada puerto de
+ ** GPIO. En el LPC43xx lo hace un timer que dispara transferencias del GPDMA, sin usar la CPU. En
+ ** posix un hilo emula el mismo comportamiento para poder probarlo en el host.
+ **
+ ** \addtogroup barrido Barrido
+ ** \brief Barrido de la pantalla por hardware
+ ** @{ */
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* === Cabecera C++ ============================================================================ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+//! Cantidad de puertos de GPIO que se escriben en cada paso (GPIO0 a GPIO5)
+#define BARRIDO_PUERTOS 6
+
+#if !defined(BARRIDO_MAX_PASOS)
+    #define BARRIDO_MAX_PASOS 8
+#endif
+
+/* === Public data type declarations =========================================================== */
+
+//! Valores que se escriben en cada puerto durante un paso del barrido
+typedef uint32_t barrido_paso_t[BARRIDO_PUERTOS];
+
+//! Funcion que la emulacion llama en cada paso con el estado de los puertos
+typedef void (*barrido_salida_t)(const uint32_t * puertos);
+
+/* === Public variable declarations ============================================================ */
+
+/* === Public function declarations ============================================================ */
+
+/**
+ * @brief Configura el timer y el canal de DMA del barrido
+ *
+ * @param periodo_us tiempo en microsegundos que dura cada paso
+ * @param habilitados bits de cada puerto que el barrido puede modificar, el resto no se toca
+ * @return true si se pudo configurar
+ */
+bool BarridoIniciar(uint32_t periodo_us, const uint32_t habilitados[BARRIDO_PUERTOS]);
+
+/**
+ * @brief Carga las tablas de pasos que se barren
+ *
+ * @param encendido pasos que se muestran normalmente
+ * @param apagado pasos que se muestran en la mitad apagada del parpadeo
+ * @param pasos cantidad de pasos de cada tabla
+ * @param pasos_parpadeo pasos que dura cada mitad del parpadeo, 0 para no parpadear
+ */
+void BarridoCargar(const barrido_paso_t * encendido, const barrido_paso_t * apagado, uint8_t pasos,
+                   uint16_t pasos_parpadeo);
+
+#if defined(POSIX)
+/**
+ * @brief Registra la funcion que recibe la salida emulada de cada paso
+ */
+void BarridoObservar(barrido_salida_t salida);
+#endif
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} End of module definition for doxygen */
+
+#endif /* BARRIDO_H */
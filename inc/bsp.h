@@ -42,6 +42,12 @@ extern "C" {
 
 /* === Public data type declarations =========================================================== */
 
+//! Ciclos de CPU consumidos por el barrido de la pantalla
+typedef struct board_cycles_s {
+    volatile uint32_t last; // ultima llamada
+    volatile uint32_t max;  // llamada mas lenta desde el arranque
+} board_cycles_s;
+
 // Se define la estructura board como publica, pero se define un puntero a una estructura constante
 // con lo cual board_s no puede ser modificada.
 typedef struct board_s {
@@ -53,6 +59,8 @@ typedef struct board_s {
     digital_input_t decrement;
     digital_input_t increment;
     display_t display;
+    board_cycles_s refresh_cycles;
+    hal_sci_t console; // puerto serie de diagnostico, NULL si no se pudo configurar
 
 } board_s;
 
@@ -64,6 +72,21 @@ typedef board_s * board_t;
 /* === Public function declarations ============================================================ */
 
 board_t BoardCreate(void);
+
+/**
+ * @brief Llama a DisplayRefresh midiendo con el contador de ciclos del nucleo cuanto tarda
+ *
+ * @param board puntero a la placa, el resultado queda en board->refresh_cycles
+ */
+void BoardDisplayRefresh(board_t board);
+
+/**
+ * @brief Habilita la lectura por interrupciones de todas las teclas del poncho
+ *
+ * @param handler funcion que recibe la tecla que cambio y su nuevo estado, sin rebotes
+ * @param object puntero que se pasa a handler
+ */
+void BoardKeysSetEventHandler(digital_input_event_t handler, void * object);
 // void SisTick_Init(uint16_t ticks);
 
 /* === End of documentation ==================================================================== */
@@ -99,6 +99,12 @@ extern "C" {
 #define TEC_4_GPIO 1
 #define TEC_4_BIT  9
 
+// Puerto serie conectado al conversor USB de la placa
+#define CONSOLE_SCI       HAL_SCI_USART2
+#define CONSOLE_TXD_PIN   HAL_PIN_P7_1
+#define CONSOLE_RXD_PIN   HAL_PIN_P7_2
+#define CONSOLE_BAUD_RATE 115200
+
 /* === Public data type declarations =========================================================== */
 
 /* === Public variable declarations ============================================================ */
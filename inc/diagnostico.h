@@ -0,0 +1,116 @@
+/************************************************************************************************
+Copyright (c) 2023, Emiliano Arnedo <emiarnedo@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#ifndef DIAGNOSTICO_H
+#define DIAGNOSTICO_H
+
+/** \brief Diagnostico del sistema operativo por el puerto serie
+ **
+ ** Mide con un contador de alta resolucion el tiempo de CPU de cada tarea y cuenta las veces que
+ ** cada una entra a ejecutar. A pedido envia por el puerto serie un reporte con esos valores,
+ ** calculados desde el reporte anterior, junto con la marca de agua de las pilas y el heap libre.
+ **
+ ** \addtogroup diagnostico Diagnostico
+ ** \brief Diagnostico del sistema operativo
+ ** @{ */
+
+/* === Headers files inclusions ================================================================ */
+
+#include "hal_sci.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* === Cabecera C++ ============================================================================ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+//! Frecuencia en Hz del contador de tiempo de ejecucion
+#define DIAGNOSTICO_FRECUENCIA 1000000
+
+//! Comando que se recibe por el puerto serie para pedir un reporte
+#define DIAGNOSTICO_COMANDO 's'
+
+/* === Public data type declarations =========================================================== */
+
+/* === Public variable declarations ============================================================ */
+
+/* === Public function declarations ============================================================ */
+
+//! Inicia el contador de tiempo de ejecucion. Lo llama el kernel al arrancar el planificador.
+void DiagnosticoIniciarContador(void);
+
+//! Devuelve el valor del contador de tiempo de ejecucion, en ciclos de DIAGNOSTICO_FRECUENCIA
+uint32_t DiagnosticoContador(void);
+
+//! Cuenta una entrada a ejecucion de la tarea. Lo llama el kernel en cada cambio de contexto.
+void DiagnosticoTareaEntrando(uint32_t numero);
+
+/**
+ * @brief Agrega un contador de la aplicacion al final del reporte
+ *
+ * @param nombre texto que se muestra antes del valor
+ * @param valor variable que se lee en cada reporte
+ * @return false si ya se agregaron DIAGNOSTICO_MAX_CONTADORES contadores
+ */
+bool DiagnosticoAgregarContador(const char * nombre, const volatile uint32_t * valor);
+
+/**
+ * @brief Avisa que la consola tiene lugar para seguir enviando el reporte o los datos
+ *
+ * Se llama desde la interrupcion del puerto serie cuando informa tx_low_water o block_sent.
+ *
+ * @return true si desperto a una tarea de mayor prioridad que la interrumpida
+ */
+bool DiagnosticoConsolaLibre(void);
+
+/**
+ * @brief Envia datos por la consola con el mismo control de flujo que el reporte
+ *
+ * Se tiene que llamar desde una tarea, que queda suspendida hasta que el puerto serie termina de
+ * enviarlos o no tiene lugar durante DIAGNOSTICO_ESPERA_CONSOLA milisegundos. Los datos no se
+ * pueden modificar hasta que vuelve.
+ *
+ * @param consola puerto serie por el que se envian los datos
+ * @param datos datos a enviar
+ * @param largo cantidad de bytes a enviar
+ */
+void DiagnosticoEnviar(hal_sci_t consola, const void * datos, int largo);
+
+/**
+ * @brief Envia el reporte de todas las tareas y del heap
+ *
+ * Se tiene que llamar desde una tarea, que queda suspendida mientras el puerto serie envia el
+ * texto. Si el puerto no puede enviarlo como un bloque por DMA, lo que no entra en la salida en
+ * DIAGNOSTICO_ESPERA_CONSOLA milisegundos se descarta.
+ *
+ * @param consola puerto serie por el que se envia el reporte
+ */
+void DiagnosticoReportar(hal_sci_t consola);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} End of module definition for doxygen */
+
+#endif /* DIAGNOSTICO_H */
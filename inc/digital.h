@@ -29,6 +29,7 @@ SPDX-License-Identifier: MIT
 /* === Headers files inclusions ================================================================ */
 #include <stdint.h>
 #include <stdbool.h>
+#include "hal_gpio.h"
 /* === Cabecera C++ ============================================================================ */
 
 #ifdef __cplusplus
@@ -40,6 +41,9 @@ extern "C" {
 typedef struct digital_output_s * digital_output_t;
 typedef struct digital_input_s * digital_input_t;
 
+//! Funcion que se llama cuando una entrada cambia de estado, despues de filtrar los rebotes
+typedef void (*digital_input_event_t)(digital_input_t input, bool active, void * object);
+
 /* === Public data type declarations =========================================================== */
 
 /* === Public variable declarations ============================================================ */
@@ -62,6 +66,22 @@ bool DigitalInputHasChanged(digital_input_t input);
 bool DigitalInputHasActivated(digital_input_t input);
 
 bool DigitalInputHasDeactivated(digital_input_t input);
+
+/**
+ * @brief Pasa la entrada a modo por interrupciones
+ *
+ * Cada flanco del terminal reinicia un timer de un disparo; cuando vence sin nuevos flancos se lee
+ * la entrada y, si cambio respecto del ultimo estado estable, se llama a handler desde la tarea
+ * de timers de FreeRTOS.
+ *
+ * @param input entrada a configurar
+ * @param gpio descriptor de la HAL del mismo terminal
+ * @param handler funcion que recibe los cambios de estado
+ * @param object puntero que se pasa a handler
+ * @return true si se pudo crear el timer de antirrebote
+ */
+bool DigitalInputSetEventHandler(digital_input_t input, hal_gpio_bit_t gpio,
+                                 digital_input_event_t handler, void * object);
 /* === End of documentation ==================================================================== */
 
 #ifdef __cplusplus
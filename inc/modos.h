@@ -0,0 +1,104 @@
+/************************************************************************************************
+Copyright (c) 2023, Emiliano Arnedo <emiarnedo@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#ifndef MODOS_H
+#define MODOS_H
+
+/** \brief Maquina de estados de la interfaz del reloj
+ **
+ ** Los modos de la interfaz y sus transiciones estan en una tabla constante indexada por
+ ** (modo, evento). Todos los eventos los procesa una unica tarea, por lo que el modulo no usa
+ ** mutex.
+ **
+ ** \addtogroup modos Modos
+ ** \brief Maquina de estados de la interfaz
+ ** @{ */
+
+/* === Headers files inclusions ================================================================ */
+
+#include "reloj.h"
+#include "pantalla.h"
+
+/* === Cabecera C++ ============================================================================ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+/* === Public data type declarations =========================================================== */
+
+typedef enum {
+    SIN_CONFIGURAR,
+    MOSTRANDO_HORA,
+    AJUSTANDO_MINUTOS_ACTUAL,
+    AJUSTANDO_HORAS_ACTUAL,
+    AJUSTANDO_MINUTOS_ALARMA,
+    AJUSTANDO_HORAS_ALARMA,
+    PANTALLA_APAGADA, // solo las teclas y las alarmas la vuelven a encender
+    MODOS_CANTIDAD,
+} modo_t;
+
+//! Eventos de la interfaz. Las teclas estan en el mismo orden que sus bits de eventos en main.
+typedef enum {
+    EVENTO_F1, // incrementar
+    EVENTO_F2, // decrementar, o apagar la pantalla mientras se muestra la hora
+    EVENTO_F3, // ajustar la alarma
+    EVENTO_F4, // ajustar la hora
+    EVENTO_ACEPTAR,
+    EVENTO_CANCELAR,
+    EVENTO_ALARMA_SONANDO,
+    EVENTO_ALARMA_CALLADA,
+    EVENTO_HORA_CONFIGURADA, // la hora se fijo sin las teclas, por ejemplo por el protocolo remoto
+    EVENTOS_CANTIDAD,
+} evento_t;
+
+typedef struct modos_s * modos_t;
+
+/* === Public variable declarations ============================================================ */
+
+/* === Public function declarations ============================================================ */
+
+/**
+ * @brief Crea la maquina de estados en SIN_CONFIGURAR
+ *
+ * @param reloj reloj que se consulta y se ajusta
+ * @param display pantalla donde se muestran los valores que se ajustan
+ */
+modos_t ModosCrear(reloj_t reloj, display_t display);
+
+/**
+ * @brief Procesa un evento: ejecuta la accion de la transicion y, si cambia de modo, la accion de
+ * entrada del modo nuevo
+ *
+ * @return modo_t modo despues del evento
+ */
+modo_t ModosProcesar(modos_t modos, evento_t evento);
+
+//! Devuelve el modo actual. Se puede leer desde otras tareas.
+modo_t ModosActual(modos_t modos);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} End of module definition for doxygen */
+
+#endif /* MODOS_H */
@@ -28,6 +28,7 @@ SPDX-License-Identifier: MIT
 
 /* === Headers files inclusions ================================================================ */
 #include <stdint.h>
+#include <stdbool.h>
 /* === Cabecera C++ ============================================================================ */
 
 #ifdef __cplusplus
@@ -65,12 +66,20 @@ typedef void (*display_segments_on_t)(uint8_t segments);
 //! Funcion de callback para prender un digito
 typedef void (*display_digit_on_t)(uint8_t digits);
 
+//! Funcion de callback opcional para barrer la pantalla por hardware. Recibe la imagen normal, la
+//! imagen con los digitos que parpadean apagados y los pasos de barrido de cada mitad del parpadeo
+typedef void (*display_scan_frames_t)(const uint8_t * frame_on, const uint8_t * frame_off,
+                                      uint8_t digits, uint16_t flashing_steps);
+
 //! "Interfaz. Coleccion de metodos que deben estar presentes si o si en la "clase" display.
 typedef struct display_driver_s {
 
     display_screen_off_t ScreenTurnOff;
     display_segments_on_t SegmentsTurnOn;
     display_digit_on_t DigitTurnOn;
+    // Opcional: si esta presente el hardware barre la pantalla y no hace falta llamar a
+    // DisplayRefresh
+    display_scan_frames_t ScanFrames;
 
 } const * const display_driver_t; // puntero constante a la estructura: no puedo modificar ninguno
                                   // de los miembros de la estructura con ese puntero ni puedo
@@ -102,6 +111,17 @@ void DisplayClearDot(display_t display, uint8_t digit_dot);
  */
 void DisplayFlashDigits(display_t display, uint8_t from, uint8_t to, uint16_t factor);
 
+/**
+ * @brief Apaga o enciende la pantalla sin perder lo que tiene escrito
+ *
+ * Apagada, DisplayRefresh deja todos los digitos apagados y el barrido por hardware recibe
+ * imagenes vacias.
+ *
+ * @param display puntero a la estructura display_s
+ * @param on true para encender la pantalla
+ */
+void DisplaySetPower(display_t display, bool on);
+
 /* === End of documentation ==================================================================== */
 
 #ifdef __cplusplus
@@ -153,36 +153,42 @@ extern "C" {
 #define KEY_F1_FUNC     SCU_MODE_FUNC4
 #define KEY_F1_GPIO     5
 #define KEY_F1_BIT      12
+#define KEY_F1_HAL      HAL_GPIO5_12
 
 #define KEY_F2_PORT     4
 #define KEY_F2_PIN      9
 #define KEY_F2_FUNC     SCU_MODE_FUNC4
 #define KEY_F2_GPIO     5
 #define KEY_F2_BIT      13
+#define KEY_F2_HAL      HAL_GPIO5_13
 
 #define KEY_F3_PORT     4
 #define KEY_F3_PIN      10
 #define KEY_F3_FUNC     SCU_MODE_FUNC4
 #define KEY_F3_GPIO     5
 #define KEY_F3_BIT      14
+#define KEY_F3_HAL      HAL_GPIO5_14
 
 #define KEY_F4_PORT     6
 #define KEY_F4_PIN      7
 #define KEY_F4_FUNC     SCU_MODE_FUNC4
 #define KEY_F4_GPIO     5
 #define KEY_F4_BIT      15
+#define KEY_F4_HAL      HAL_GPIO5_15
 
 #define KEY_ACCEPT_PIN  2
 #define KEY_ACCEPT_PORT 3
 #define KEY_ACCEPT_FUNC SCU_MODE_FUNC4
 #define KEY_ACCEPT_GPIO 5
 #define KEY_ACCEPT_BIT  9
+#define KEY_ACCEPT_HAL  HAL_GPIO5_9
 
 #define KEY_CANCEL_PORT 3
 #define KEY_CANCEL_PIN  1
 #define KEY_CANCEL_FUNC SCU_MODE_FUNC4
 #define KEY_CANCEL_GPIO 5
 #define KEY_CANCEL_BIT  8
+#define KEY_CANCEL_HAL  HAL_GPIO5_8
 
 // Definiciones de los recursos asociados al zumbador
 #define BUZZER_PORT 2
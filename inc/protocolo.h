@@ -0,0 +1,157 @@
+/************************************************************************************************
+Copyright (c) 2023, Emiliano Arnedo <emiarnedo@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+
+#ifndef PROTOCOLO_H
+#define PROTOCOLO_H
+
+/** \brief Protocolo binario para configurar el reloj por la consola
+ **
+ ** Cada trama es un pedido o una respuesta con su CRC-16/CCITT (polinomio 0x1021, valor inicial
+ ** 0xFFFF, el resultado en big endian al final), codificado con COBS y entre dos bytes 0x00. Los
+ ** bytes que llegan fuera de una trama son texto de la consola, asi el comando de diagnostico
+ ** sigue funcionando. Varios ceros seguidos son un solo delimitador.
+ **
+ ** Un pedido es el comando, un numero de secuencia que elige quien pregunta y los datos del
+ ** comando. La respuesta repite el comando con el bit 7 en uno y la secuencia, y sigue con el
+ ** estado y los datos de la respuesta. Las horas van en BCD empaquetado (0x23 0x59 para 23:59).
+ ** Se atiende un pedido por vez: los que llegan mientras se responde el anterior se descartan.
+ **
+ ** \addtogroup protocolo Protocolo
+ ** \brief Protocolo binario de configuracion remota
+ ** @{ */
+
+/* === Headers files inclusions ================================================================ */
+
+#include "modos.h"
+#include "reloj.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* === Cabecera C++ ============================================================================ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+//! Largo maximo de un pedido o una respuesta decodificados, con el comando, la secuencia y el CRC
+#if !defined(PROTOCOLO_MAX_TRAMA)
+    #define PROTOCOLO_MAX_TRAMA 200
+#endif
+
+//! Largo de la trama codificada de un mensaje de largo bytes sin el CRC, con los delimitadores
+#define PROTOCOLO_LARGO_CODIFICADO(largo) ((largo) + 2 + ((largo) + 2) / 254 + 1 + 2)
+
+// Comandos. Los datos de cada uno se describen como pedido -> respuesta.
+#define PROTOCOLO_LEER_ESTADO     0x01 // -> hh mm ss dia valida sonando alarmas modo
+#define PROTOCOLO_FIJAR_HORA      0x02 // hh mm ss [dia] ->
+#define PROTOCOLO_AGREGAR_ALARMA  0x03 // hh mm dias repetir -> alarma
+#define PROTOCOLO_BORRAR_ALARMA   0x04 // alarma, o PROTOCOLO_TODAS ->
+#define PROTOCOLO_LISTAR_ALARMAS  0x05 // [desde] -> alarma hh mm dias banderas, las que entren
+#define PROTOCOLO_CONFIGURAR      0x06 // hh mm ss dia, hh mm dias repetir de cada alarma -> alarmas
+#define PROTOCOLO_RESPUESTA       0x80 // se suma al comando en la respuesta
+
+//! Alarma de PROTOCOLO_BORRAR_ALARMA para borrar toda la tabla, y alarma sonando si no hay ninguna
+#define PROTOCOLO_TODAS 0xFF
+
+// Banderas de las alarmas
+#define PROTOCOLO_REPETIR    (1 << 0) // la alarma suena todos los dias de su mascara
+#define PROTOCOLO_PROGRAMADA (1 << 1) // solo en la lista: la alarma va a sonar
+
+// Estados de la respuesta
+#define PROTOCOLO_OK            0x00
+#define PROTOCOLO_DESCONOCIDO   0x01 // comando desconocido
+#define PROTOCOLO_LARGO_ERRONEO 0x02 // los datos no tienen el largo del comando
+#define PROTOCOLO_VALOR_ERRONEO 0x03 // hora, dia o alarma fuera de rango
+#define PROTOCOLO_TABLA_LLENA   0x04 // no entran mas alarmas
+
+/* === Public data type declarations =========================================================== */
+
+//! Resultado de procesar un byte recibido
+typedef enum {
+    PROTOCOLO_TEXTO,  // el byte esta fuera de una trama, es texto de la consola
+    PROTOCOLO_TRAMA,  // el byte es parte de una trama
+    PROTOCOLO_PEDIDO, // el byte completo un pedido valido, hay que llamar a ProtocoloEjecutar
+} protocolo_recepcion_t;
+
+typedef struct protocolo_s * protocolo_t;
+
+/* === Public variable declarations ============================================================ */
+
+/* === Public function declarations ============================================================ */
+
+/**
+ * @brief Crea el protocolo, sobre memoria estatica
+ *
+ * @param reloj reloj que se consulta y se configura
+ * @param modos maquina de estados a la que se avisa cuando se fija la hora
+ */
+protocolo_t ProtocoloCrear(reloj_t reloj, modos_t modos);
+
+/**
+ * @brief Procesa un byte recibido por la consola
+ *
+ * Se llama desde la interrupcion del puerto serie. Decodifica la trama y calcula su CRC a medida
+ * que llegan los bytes, por lo que al recibir el delimitador final el pedido ya esta verificado.
+ */
+protocolo_recepcion_t ProtocoloRecibir(protocolo_t protocolo, uint8_t dato);
+
+/**
+ * @brief Ejecuta el pedido recibido y arma la respuesta
+ *
+ * Se tiene que llamar desde la tarea duena del reloj y de la maquina de estados. Hasta que se
+ * llama a ProtocoloLiberar no se reciben mas pedidos.
+ *
+ * @return false si no habia un pedido
+ */
+bool ProtocoloEjecutar(protocolo_t protocolo);
+
+/**
+ * @brief Devuelve la trama codificada de la respuesta
+ *
+ * @param datos puntero a la trama, que no cambia hasta ProtocoloLiberar
+ * @return uint16_t largo de la trama, cero si no hay una respuesta
+ */
+uint16_t ProtocoloRespuesta(protocolo_t protocolo, const uint8_t ** datos);
+
+//! Descarta el pedido y la respuesta, para recibir el proximo pedido
+void ProtocoloLiberar(protocolo_t protocolo);
+
+//! Devuelve la cantidad de tramas descartadas por error de CRC, de formato o por estar ocupado
+const volatile uint32_t * ProtocoloDescartadas(protocolo_t protocolo);
+
+/**
+ * @brief Agrega el CRC a un mensaje y lo codifica como una trama, con sus delimitadores
+ *
+ * @param datos mensaje, con dos bytes libres al final para el CRC
+ * @param largo largo del mensaje sin el CRC
+ * @param trama donde se escribe la trama, de PROTOCOLO_LARGO_CODIFICADO(largo) bytes
+ * @return uint16_t largo de la trama
+ */
+uint16_t ProtocoloCodificar(uint8_t * datos, uint16_t largo, uint8_t * trama);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} End of module definition for doxygen */
+
+#endif /* PROTOCOLO_H */
@@ -31,24 +31,148 @@ extern "C" {
 
 #define TICKS_PER_SECOND 1000 // Cuantos ticks debe contar el reloj para sumar un segundo
 
+// Capacidad de la tabla de alarmas, como mucho 255. Se puede cambiar desde el makefile.
+#ifndef ALARM_INSTANCES
+    #define ALARM_INSTANCES 32
+#endif
+
+// Mascaras de dias de la semana para las alarmas
+#define ALARMA_DOMINGO        (1 << 0)
+#define ALARMA_LUNES          (1 << 1)
+#define ALARMA_MARTES         (1 << 2)
+#define ALARMA_MIERCOLES      (1 << 3)
+#define ALARMA_JUEVES         (1 << 4)
+#define ALARMA_VIERNES        (1 << 5)
+#define ALARMA_SABADO         (1 << 6)
+#define ALARMA_TODOS_LOS_DIAS 0x7F
+
 /* === Public data type declarations =========================================================== */
 
 typedef struct reloj_s * reloj_t;
 typedef void (*callback_disparar)(reloj_t reloj,
                                   bool act_desact); // funcion de callback que facilita el testing
 
+/**
+ * @brief Fuente de tiempo del reloj: un contador monotono que se lee en O(1)
+ *
+ * El reloj no hace ningun trabajo por cuenta, solo lee el contador cuando se lo consulta.
+ */
+typedef struct reloj_fuente_s {
+    void (*Iniciar)(void);  // opcional, configura el hardware del contador
+    uint32_t (*Leer)(void); // valor actual del contador, puede desbordar
+    uint32_t frecuencia;    // cuentas por segundo
+    // Opcional, para fuentes de 1 Hz: registra la funcion que se llama desde la interrupcion en
+    // cada cambio de segundo, o la deshabilita con NULL
+    void (*AvisarSegundo)(void (*aviso)(void));
+} const * reloj_fuente_t;
+
+//! Configuracion de una alarma de la tabla de alarmas
+typedef struct alarma_config_s {
+    uint8_t hora[4]; // hh:mm en BCD, igual que en SetAlarmTime
+    uint8_t dias;    // mascara ALARMA_*, 0 equivale a todos los dias
+    bool repetir;    // false: la alarma suena una sola vez y se descarta al cancelarla
+} const * alarma_config_t;
+
 /* === Public variable declarations ============================================================ */
 
 /* === Public function declarations ============================================================ */
 
 reloj_t ClockCreate(int ticks_por_segundo, callback_disparar funcion_de_disparo);
 
+/**
+ * @brief Crea el reloj sobre una fuente de tiempo, que se inicia si hace falta
+ *
+ * El segundo del reloj empieza en el valor actual de la fuente.
+ */
+reloj_t ClockCreateFromSource(reloj_fuente_t fuente, callback_disparar funcion_de_disparo);
+
+/**
+ * @brief Lee la fuente de tiempo y actualiza el reloj, igual que ClockGetTimeAt
+ *
+ * @return int cuentas de la fuente transcurridas dentro del segundo actual
+ */
+int ClockUpdate(reloj_t reloj);
+
+/**
+ * @brief Copia la hora actual en BCD (hhmmss)
+ *
+ * Junto con GetClockWeekday se puede llamar desde cualquier tarea mientras otra actualiza el
+ * reloj, sin bloquearla, y siempre devuelve una hora consistente. El resto de las funciones que
+ * modifican el reloj o sus alarmas se tienen que llamar desde una sola tarea a la vez.
+ *
+ * @return true si la hora es valida
+ */
 bool GetClockTime(reloj_t reloj, uint8_t * hora, int size);
 
 bool SetClockTime(reloj_t reloj, const uint8_t * hora, int size);
 
 int RelojNuevoTick(reloj_t reloj);
 
+/**
+ * @brief Avanza n_ticks el contador propio del reloj en una sola llamada
+ *
+ * El costo no depende de n_ticks, solo de la cantidad de alarmas que se disparen en el medio, que
+ * suenan una vez cada una y en orden.
+ *
+ * @return int ticks transcurridos dentro del segundo actual
+ */
+int RelojAdvance(reloj_t reloj, uint32_t n_ticks);
+
+/**
+ * @brief Actualiza el reloj a partir de un contador de ticks monotono absoluto.
+ *
+ * Procesa todos los segundos (y alarmas) transcurridos hasta tick_count, sin importar cuanto
+ * tiempo paso desde la ultima llamada. La hora se lee despues con GetClockTime.
+ *
+ * @param reloj puntero a la estructura reloj_s
+ * @param tick_count valor actual del contador de ticks (puede desbordar)
+ * @return int ticks transcurridos dentro del segundo actual
+ */
+int ClockGetTimeAt(reloj_t reloj, uint32_t tick_count);
+
+/**
+ * @brief Devuelve el valor del contador absoluto en que el reloj cambia al siguiente segundo.
+ *
+ * Permite que una tarea duerma hasta ese instante en lugar de consultar el reloj cada tick.
+ */
+uint32_t ClockNextEventTick(reloj_t reloj);
+/**
+ * @brief Devuelve el valor del contador absoluto en que suena la proxima alarma programada.
+ *
+ * Permite dormir hasta la alarma cuando no hace falta mostrar la hora. Si no hay alarmas, o si
+ * faltan mas de max_segundos, devuelve el instante que esta max_segundos mas adelante.
+ */
+uint32_t ClockNextAlarmTick(reloj_t reloj, uint32_t max_segundos);
+
+/**
+ * @brief Fija el dia de la semana actual (0 = domingo), usado por las mascaras de las alarmas.
+ */
+bool SetClockWeekday(reloj_t reloj, uint8_t dia_semana);
+
+uint8_t GetClockWeekday(reloj_t reloj);
+
+/**
+ * @brief Agrega una alarma a la tabla de alarmas del reloj.
+ *
+ * La tabla tiene capacidad fija (ALARM_INSTANCES) y se mantiene ordenada por el proximo disparo,
+ * por lo que agregar o borrar una alarma cuesta O(log n) y verificarlas O(1) por segundo.
+ *
+ * @return int identificador de la alarma, o -1 si la tabla esta llena
+ */
+int AgregarAlarma(reloj_t reloj, alarma_config_t config);
+
+bool BorrarAlarma(reloj_t reloj, int alarma);
+
+/**
+ * @brief Lee la configuracion de una entrada de la tabla de alarmas
+ * @param programada false si la alarma esta deshabilitada o si era de una sola vez y ya sono
+ * @return false si la entrada no esta en uso
+ */
+bool LeerAlarma(reloj_t reloj, int alarma, struct alarma_config_s * config, bool * programada);
+
+//! Devuelve el identificador de la ultima alarma disparada, o -1 si no hay ninguna sonando
+int AlarmaSonando(reloj_t reloj);
+
 bool SetAlarmTime(reloj_t reloj, const uint8_t * alarma);
 
 bool GetAlarmTime(reloj_t reloj, uint8_t * alarma);
@@ -0,0 +1,98 @@
+/************************************************************************************************
+Copyright (c) 2023, Emiliano Arnedo <emiarnedo@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+
+#ifndef SIMULACION_H
+#define SIMULACION_H
+
+/** \brief Guiones de teclas y tiempo para simular el reloj en posix
+ **
+ ** Un guion es una lista de pasos: cuanto tiempo simulado pasa y que evento de la interfaz se
+ ** inyecta despues. Junto con FUENTE_SIMULADA permite recorrer dias de funcionamiento del reloj y
+ ** sus alarmas en pocos segundos, sin el sistema operativo: cada paso hace lo mismo que las tareas
+ ** del programa, en orden. El texto tiene un paso por linea, con los segundos y el nombre
+ ** del evento (F1, F2, F3, F4, ACEPTAR, CANCELAR, o - para ninguno). Lo que sigue a un # se ignora.
+ **
+ ** \addtogroup simulacion Simulacion
+ ** \brief Guiones de teclas y tiempo para la simulacion
+ ** @{ */
+
+/* === Headers files inclusions ================================================================ */
+
+#include "modos.h"
+#include "reloj.h"
+#include <stdint.h>
+
+/* === Cabecera C++ ============================================================================ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+//! Evento de los pasos que solo dejan pasar el tiempo. ModosProcesar lo ignora.
+#define SIMULACION_SIN_EVENTO EVENTOS_CANTIDAD
+
+/* === Public data type declarations =========================================================== */
+
+//! Paso de un guion
+typedef struct simulacion_paso_s {
+    uint32_t segundos; // tiempo simulado que pasa antes del evento
+    evento_t evento;   // evento que se inyecta, o SIMULACION_SIN_EVENTO
+} simulacion_paso_t;
+
+/* === Public variable declarations ============================================================ */
+
+/* === Public function declarations ============================================================ */
+
+/**
+ * @brief Convierte el texto de un guion en su lista de pasos
+ *
+ * @param texto guion, terminado en cero
+ * @param guion pasos leidos
+ * @param maximo cantidad de pasos que entran en guion
+ * @return int cantidad de pasos, o -1 si alguna linea no se entiende o no entran todos
+ */
+int SimulacionLeerGuion(const char * texto, simulacion_paso_t * guion, int maximo);
+
+/**
+ * @brief Funcion de disparo para el reloj que se simula, guarda los eventos de alarma para
+ * SimulacionEjecutar
+ */
+void SimulacionAlarma(reloj_t reloj, bool act_desact);
+
+/**
+ * @brief Recorre un guion sobre FUENTE_SIMULADA
+ *
+ * Cada paso adelanta el tiempo simulado, actualiza el reloj, procesa las alarmas que sonaron y
+ * despues inyecta el evento del paso. El reloj se tiene que crear sobre FUENTE_SIMULADA con
+ * SimulacionAlarma como funcion de disparo.
+ *
+ * @return int cantidad de veces que sono una alarma
+ */
+int SimulacionEjecutar(modos_t modos, reloj_t reloj, const simulacion_paso_t * guion, int pasos);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} End of module definition for doxygen */
+
+#endif /* SIMULACION_H */
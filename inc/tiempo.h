@@ -0,0 +1,84 @@
+/************************************************************************************************
+Copyright (c) 2023, Emiliano Arnedo <emiarnedo@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#ifndef TIEMPO_H
+#define TIEMPO_H
+
+/** \brief Fuentes de tiempo por hardware para el reloj
+ **
+ ** Cada fuente entrega un contador monotono que el reloj lee cuando lo consultan, sin trabajo por
+ ** tick. En los microcontroladores es el RTC, que sigue contando con la bateria de respaldo aunque
+ ** se reinicie el procesador. En posix es el reloj monotonico del sistema, o un reloj simulado que
+ ** corre mas rapido que el real o solo avanza cuando se lo piden.
+ **
+ ** \addtogroup tiempo Tiempo
+ ** \brief Fuentes de tiempo por hardware
+ ** @{ */
+
+/* === Headers files inclusions ================================================================ */
+
+#include "reloj.h"
+
+/* === Cabecera C++ ============================================================================ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+/* === Public data type declarations =========================================================== */
+
+/* === Public variable declarations ============================================================ */
+
+#if defined(LPC43XX) || defined(STM32F1XX)
+//! RTC del microcontrolador, cuenta segundos y avisa por interrupcion cada cambio de segundo
+extern const reloj_fuente_t FUENTE_RTC;
+#endif
+
+#if defined(POSIX)
+//! Reloj monotonico del sistema, en milisegundos
+extern const reloj_fuente_t FUENTE_MONOTONICA;
+
+//! Reloj simulado, en milisegundos. Empieza detenido, ver SimulacionVelocidad.
+extern const reloj_fuente_t FUENTE_SIMULADA;
+#endif
+
+/* === Public function declarations ============================================================ */
+
+#if defined(POSIX)
+/**
+ * @brief Cambia la velocidad del reloj simulado, sin saltos en el tiempo ya transcurrido
+ *
+ * @param velocidad milisegundos simulados por cada milisegundo real, 0 para que el tiempo solo
+ * avance con SimulacionAvanzar
+ */
+void SimulacionVelocidad(uint32_t velocidad);
+
+//! Adelanta el reloj simulado, ademas de lo que avance por su velocidad
+void SimulacionAvanzar(uint32_t milisegundos);
+#endif
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} End of module definition for doxygen */
+
+#endif /* TIEMPO_H */
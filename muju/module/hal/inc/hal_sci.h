@@ -81,15 +81,33 @@ typedef struct hal_sci_pins_s {
  * @brief Structure with the status flags of a serial port
  */
 typedef struct sci_status_s {
-    bool data_ready : 1;          /**< The new data is ready in the input fifo on hardware */
+    bool data_ready : 1;          /**< The new data is ready in input ring or fifo on hardware */
     bool overrun : 1;             /**< Data in input fifo on hardware was overwritten by new data */
     bool parity_error : 1;        /**< Error in the parity check of the received data */
     bool framing_error : 1;       /**< Error in the start or stop bits in the received data */
     bool break_signal : 1;        /**< Signal break detected on reception line */
     bool fifo_empty : 1;          /**< Output fifo on hardware are ready to accept more data */
     bool tramition_completed : 1; /**< Tranmission of data in output fifo on hardware completed */
+    bool tx_low_water : 1;        /**< Pending output data dropped to the low water mark (events) */
+    bool rx_high_water : 1;       /**< Pending input data reached the high water mark (events) */
+    bool block_sent : 1;          /**< The block given to SciSendBlock was sent (events) */
 } * sci_status_t;
 
+/**
+ * @brief Structure to define the memory used to buffer the data of a serial port
+ *
+ * A ring with NULL data or zero size is not used, and that direction goes straight to the fifo
+ * on hardware. A ring holds one byte less than its size.
+ */
+typedef struct hal_sci_buffers_s {
+    uint8_t * tx_data;      /**< Memory for the output ring */
+    uint16_t tx_size;       /**< Length of the memory for the output ring */
+    uint16_t tx_low_water;  /**< Pending output data that raises the low water event */
+    uint8_t * rx_data;      /**< Memory for the input ring */
+    uint16_t rx_size;       /**< Length of the memory for the input ring */
+    uint16_t rx_high_water; /**< Pending input data that raises the high water event */
+} const * hal_sci_buffers_t;
+
 /**
  * @brief Pointer to the structure with the serial port descriptor
  */
@@ -120,7 +138,22 @@ typedef void (*hal_sci_event_t)(hal_sci_t sci, sci_status_t status, void * objec
 bool SciSetConfig(hal_sci_t sci, hal_sci_line_t line, hal_sci_pins_t pins);
 
 /**
- * @brief Function to put data into output fifo on hardware
+ * @brief Function to assign ring buffers to a serial port
+ *
+ * The rings are filled and drained from the serial port interrupt, which is enabled here. With
+ * an output ring the low water event is raised when the interrupt drains the pending data down
+ * to the mark, without it when the fifo on hardware gets empty. The high water event is raised
+ * in every input interrupt that leaves the input ring at or over the mark.
+ *
+ * @param  sci      Pointer to the structure with the serial port descriptor
+ * @param  buffers  Pointer to structure with the memory for the rings
+ * @return true     The rings are in use
+ * @return false    The serial port can't use rings
+ */
+bool SciSetBuffers(hal_sci_t sci, hal_sci_buffers_t buffers);
+
+/**
+ * @brief Function to put data into output ring, or into output fifo on hardware without a ring
  *
  * @param  sci      Pointer to the structure with the serial port descriptor
  * @param  data     Pointer to buffer with data to put in output fifo
@@ -130,7 +163,21 @@ bool SciSetConfig(hal_sci_t sci, hal_sci_line_t line, hal_sci_pins_t pins);
 uint16_t SciSendData(hal_sci_t sci, void const * const data, uint16_t size);
 
 /**
- * @brief Function to get data from input fifo on hardware
+ * @brief Function to send a block of data by DMA, without copying it and without work per byte
+ *
+ * The memory of the block belongs to the caller and can't change until the event handler gets
+ * block_sent, which is raised even if the transfer fails. While the block is sent the output
+ * ring keeps accepting data, and starts to drain after the block.
+ *
+ * @param  sci      Pointer to the structure with the serial port descriptor
+ * @param  data     Pointer to buffer with data to send
+ * @param  size     Length of data to send
+ * @return uint16_t Amount of data that will be sent, zero if the port is busy or can't use DMA
+ */
+uint16_t SciSendBlock(hal_sci_t sci, void const * const data, uint16_t size);
+
+/**
+ * @brief Function to get data from input ring, or from input fifo on hardware without a ring
  *
  * @param  sci      Pointer to the structure with the serial port descriptor
  * @param  data     Pointer to the buffer to store data from input fifo
@@ -56,6 +56,11 @@ SPDX-License-Identifier: MIT
 #define HAL_SCI_NVIC_PRIORITY 0
 #endif
 
+/**
+ * @brief Macro with the largest block that a single GPDMA transfer can send
+ */
+#define SCI_DMA_MAX_BLOCK 0xFFF
+
 /* === Private data type declarations ========================================================== */
 
 /**
@@ -64,7 +69,8 @@ SPDX-License-Identifier: MIT
 struct hal_sci_s {
     LPC_USART_T * port; /**< Pointer to the memory area with the serial port registers */
     IRQn_Type interupt; /**< Interrupt number corresponding to the serial port */
-    uint8_t index;      /**< Numeric index of serial port */
+    uint8_t index;      /**< Numeric index of serial port, also used as its GPDMA channel */
+    uint8_t dma;        /**< GPDMA connection of the transmission requests of the serial port */
 };
 
 /**
@@ -75,6 +81,26 @@ typedef struct event_handler_s {
     void * data;             /**< Pointer to user data sended as parameter in handler calls */
 } * event_handler_t;
 
+/**
+ * @brief Structure to store a ring buffer shared between the serial port interrupt and a task
+ */
+typedef struct sci_ring_s {
+    uint8_t * data;         /**< Memory of the ring, NULL when the ring is not in use */
+    uint16_t size;          /**< Length of the memory of the ring */
+    uint16_t mark;          /**< Pending data that raises the water event */
+    volatile uint16_t head; /**< Position to write the next data, only moved by the producer */
+    volatile uint16_t tail; /**< Position to read the next data, only moved by the consumer */
+} * sci_ring_t;
+
+/**
+ * @brief Structure to store the rings of a serial port
+ */
+typedef struct sci_buffers_s {
+    struct sci_ring_s tx; /**< Ring with data waiting to be put in output fifo on hardware */
+    struct sci_ring_s rx; /**< Ring with data taken from input fifo on hardware */
+    volatile bool block;  /**< A block is being sent by DMA, the output ring waits for it */
+} * sci_buffers_t;
+
 /* === Private variable declarations =========================================================== */
 
 /* === Private function declarations ===========================================================  */
@@ -123,6 +149,66 @@ static bool ConfigPinsUsart3(hal_sci_pins_t pins);
  */
 static uint32_t LineEncodeBits(hal_sci_line_t line);
 
+/**
+ * @brief Function to decode the line status register as serial port status flags
+ *
+ * @param  status   Value of the line status register
+ * @param  result   Pointer to structure to write the status flags of a serial port
+ */
+static void LineDecodeStatus(uint32_t status, sci_status_t result);
+
+/**
+ * @brief Function to get the amount of pending data in a ring
+ *
+ * @param  ring     Pointer to the structure with the ring
+ * @return uint16_t Amount of data written and not yet read
+ */
+static uint16_t RingCount(sci_ring_t ring);
+
+/**
+ * @brief Function to write data into a ring
+ *
+ * @param  ring     Pointer to the structure with the ring
+ * @param  data     Pointer to buffer with data to write
+ * @param  size     Length of data to write
+ * @return uint16_t Amount of data actually written
+ */
+static uint16_t RingWrite(sci_ring_t ring, uint8_t const * data, uint16_t size);
+
+/**
+ * @brief Function to read data from a ring
+ *
+ * @param  ring     Pointer to the structure with the ring
+ * @param  data     Pointer to the buffer to store data read
+ * @param  size     Length of data to read
+ * @return uint16_t Amount of data actually read
+ */
+static uint16_t RingRead(sci_ring_t ring, uint8_t * data, uint16_t size);
+
+/**
+ * @brief Function to move data from output ring to output fifo on hardware when it is empty
+ *
+ * @param  sci      Pointer to the structure with the serial port descriptor
+ * @param  ring     Pointer to the structure with the output ring
+ */
+static void RingTransmit(hal_sci_t sci, sci_ring_t ring);
+
+/**
+ * @brief Function to move data from input fifo on hardware to input ring
+ *
+ * @param  sci      Pointer to the structure with the serial port descriptor
+ * @param  ring     Pointer to the structure with the input ring
+ * @return uint32_t Line status registers read while moving data, or'ed together
+ */
+static uint32_t RingReceive(hal_sci_t sci, sci_ring_t ring);
+
+/**
+ * @brief Function to enable the interrupts of a serial port
+ *
+ * @param  sci  Pointer to the structure with the serial port descriptor
+ */
+static void SciEnableInterrupts(hal_sci_t sci);
+
 /**
  * @brief Function to dispatch an sci port event when the device raises an interrupt
  *
@@ -130,6 +216,13 @@ static uint32_t LineEncodeBits(hal_sci_line_t line);
  */
 static void SciHandleEvent(hal_sci_t sci);
 
+/**
+ * @brief Function to dispatch the end of a block when the GPDMA raises an interrupt
+ *
+ * @param  sci  Pointer to the structure with the serial port descriptor
+ */
+static void SciHandleBlock(hal_sci_t sci);
+
 /* === Public variable definitions ============================================================= */
 
 /**
@@ -139,20 +232,20 @@ static void SciHandleEvent(hal_sci_t sci);
  */
 
 /** Constant to define serial port 0 */
-const hal_sci_t HAL_SCI_USART0 =
-    &(struct hal_sci_s){.port = LPC_USART0, .interupt = USART0_IRQn, .index = 0};
+const hal_sci_t HAL_SCI_USART0 = &(struct hal_sci_s){
+    .port = LPC_USART0, .interupt = USART0_IRQn, .index = 0, .dma = GPDMA_CONN_UART0_Tx};
 
 /** Constant to define serial port 1 */
-const hal_sci_t HAL_SCI_UART1 =
-    &(struct hal_sci_s){.port = LPC_UART1, .interupt = UART1_IRQn, .index = 1};
+const hal_sci_t HAL_SCI_UART1 = &(struct hal_sci_s){
+    .port = LPC_UART1, .interupt = UART1_IRQn, .index = 1, .dma = GPDMA_CONN_UART1_Tx};
 
 /** Constant to define serial port 2 */
-const hal_sci_t HAL_SCI_USART2 =
-    &(struct hal_sci_s){.port = LPC_USART2, .interupt = USART2_IRQn, .index = 2};
+const hal_sci_t HAL_SCI_USART2 = &(struct hal_sci_s){
+    .port = LPC_USART2, .interupt = USART2_IRQn, .index = 2, .dma = GPDMA_CONN_UART2_Tx};
 
 /** Constant to define serial port 3 */
-const hal_sci_t HAL_SCI_USART3 =
-    &(struct hal_sci_s){.port = LPC_USART3, .interupt = USART3_IRQn, .index = 3};
+const hal_sci_t HAL_SCI_USART3 = &(struct hal_sci_s){
+    .port = LPC_USART3, .interupt = USART3_IRQn, .index = 3, .dma = GPDMA_CONN_UART3_Tx};
 
 /** @} End of group lpc43xxSci */
 
@@ -163,6 +256,11 @@ const hal_sci_t HAL_SCI_USART3 =
  */
 static struct event_handler_s event_handlers[4] = {0};
 
+/**
+ * @brief Vector to store the rings of the serial ports
+ */
+static struct sci_buffers_s sci_buffers[4] = {0};
+
 /* === Private function implementation ========================================================= */
 
 static bool ConfigPinsUsart0(hal_sci_pins_t pins) {
@@ -333,14 +431,142 @@ static uint32_t LineEncodeBits(hal_sci_line_t line) {
     return config;
 }
 
+static void LineDecodeStatus(uint32_t status, sci_status_t result) {
+    result->data_ready = status & UART_LSR_RDR;
+    result->overrun = status & UART_LSR_OE;
+    result->parity_error = status & UART_LSR_PE;
+    result->framing_error = status & UART_LSR_FE;
+    result->break_signal = status & UART_LSR_BI;
+    result->fifo_empty = status & UART_LSR_THRE;
+    result->tramition_completed = status & UART_LSR_TEMT;
+    result->tx_low_water = false;
+    result->rx_high_water = false;
+    result->block_sent = false;
+}
+
+static uint16_t RingCount(sci_ring_t ring) {
+    return ((uint32_t)ring->head + ring->size - ring->tail) % ring->size;
+}
+
+static uint16_t RingWrite(sci_ring_t ring, uint8_t const * data, uint16_t size) {
+    uint16_t head = ring->head;
+    uint16_t result = 0;
+
+    while (result < size) {
+        uint16_t next = (head + 1 == ring->size) ? 0 : head + 1;
+        if (next == ring->tail) {
+            break;
+        }
+        ring->data[head] = data[result++];
+        head = next;
+    }
+    ring->head = head;
+    return result;
+}
+
+static uint16_t RingRead(sci_ring_t ring, uint8_t * data, uint16_t size) {
+    uint16_t tail = ring->tail;
+    uint16_t result = 0;
+
+    while ((result < size) && (tail != ring->head)) {
+        data[result++] = ring->data[tail];
+        tail = (tail + 1 == ring->size) ? 0 : tail + 1;
+    }
+    ring->tail = tail;
+    return result;
+}
+
+static void RingTransmit(hal_sci_t sci, sci_ring_t ring) {
+    uint8_t data[UART_TX_FIFO_SIZE];
+    uint16_t size;
+
+    // With THRE set the whole fifo is empty, so it takes a full load without checking each byte
+    if (Chip_UART_ReadLineStatus(sci->port) & UART_LSR_THRE) {
+        size = RingRead(ring, data, sizeof(data));
+        for (int index = 0; index < size; index++) {
+            Chip_UART_SendByte(sci->port, data[index]);
+        }
+    }
+}
+
+static uint32_t RingReceive(hal_sci_t sci, sci_ring_t ring) {
+    uint32_t result = 0;
+    uint32_t status;
+    uint8_t data;
+
+    status = Chip_UART_ReadLineStatus(sci->port);
+    while (status & UART_LSR_RDR) {
+        data = Chip_UART_ReadByte(sci->port);
+        if (RingWrite(ring, &data, 1) == 0) {
+            status |= UART_LSR_OE;
+        }
+        result |= status;
+        status = Chip_UART_ReadLineStatus(sci->port);
+    }
+    return result | status;
+}
+
+static void SciEnableInterrupts(hal_sci_t sci) {
+    Chip_UART_ReadLineStatus(sci->port);
+    NVIC_ClearPendingIRQ(sci->interupt);
+    NVIC_SetPriority(sci->interupt, HAL_SCI_NVIC_PRIORITY);
+    NVIC_EnableIRQ(sci->interupt);
+    Chip_UART_IntEnable(sci->port, UART_IER_RBRINT);
+    Chip_UART_IntEnable(sci->port, UART_IER_THREINT);
+    Chip_UART_IntEnable(sci->port, UART_IER_RLSINT);
+}
+
 static void SciHandleEvent(hal_sci_t sci) {
     if (sci) {
         event_handler_t event_handler = &event_handlers[sci->index];
+        sci_buffers_t buffers = &sci_buffers[sci->index];
         struct sci_status_s status;
+        uint32_t interrupt;
+        uint16_t pending;
+
+        interrupt = Chip_UART_ReadIntIDReg(sci->port) & UART_IIR_INTID_MASK;
+
+        if (buffers->rx.data) {
+            LineDecodeStatus(RingReceive(sci, &buffers->rx), &status);
+            pending = RingCount(&buffers->rx);
+            status.data_ready = (pending > 0);
+            status.rx_high_water = (pending >= buffers->rx.mark);
+        } else {
+            SciReadStatus(sci, &status);
+        }
+
+        if (buffers->block) {
+            status.tx_low_water = false;
+        } else if (buffers->tx.data) {
+            pending = RingCount(&buffers->tx);
+            RingTransmit(sci, &buffers->tx);
+            status.tx_low_water =
+                (pending > buffers->tx.mark) && (RingCount(&buffers->tx) <= buffers->tx.mark);
+        } else {
+            status.tx_low_water = (interrupt == UART_IIR_INTID_THRE);
+        }
+
+        if (event_handler->handler) {
+            event_handler->handler(sci, &status, event_handler->data);
+        }
+    }
+}
+
+static void SciHandleBlock(hal_sci_t sci) {
+    event_handler_t event_handler = &event_handlers[sci->index];
+    sci_buffers_t buffers = &sci_buffers[sci->index];
+    struct sci_status_s status;
 
-        (void)Chip_UART_ReadIntIDReg(sci->port);
+    if (buffers->block && Chip_GPDMA_IntGetStatus(LPC_GPDMA, GPDMA_STAT_INT, sci->index)) {
+        // Clears the end or the error of the transfer, in both cases the block is over
+        (void)Chip_GPDMA_Interrupt(LPC_GPDMA, sci->index);
+        buffers->block = false;
 
         SciReadStatus(sci, &status);
+        if (buffers->tx.data) {
+            RingTransmit(sci, &buffers->tx);
+        }
+        status.block_sent = true;
         if (event_handler->handler) {
             event_handler->handler(sci, &status, event_handler->data);
         }
@@ -372,17 +598,82 @@ bool SciSetConfig(hal_sci_t sci, hal_sci_line_t line, hal_sci_pins_t pins) {
             Chip_UART_Init(sci->port);
             Chip_UART_SetBaud(sci->port, line->baud_rate);
             Chip_UART_ConfigData(sci->port, LineEncodeBits(line));
-            Chip_UART_SetupFIFOS(sci->port, UART_FCR_FIFO_EN | UART_FCR_TRG_LEV0);
+            Chip_UART_SetupFIFOS(sci->port,
+                                 UART_FCR_FIFO_EN | UART_FCR_TRG_LEV0 | UART_FCR_DMAMODE_SEL);
             Chip_UART_TXEnable(sci->port);
         }
     }
     return result;
 }
 
+bool SciSetBuffers(hal_sci_t sci, hal_sci_buffers_t buffers) {
+    bool result = false;
+
+    if (sci) {
+        sci_buffers_t rings = &sci_buffers[sci->index];
+
+        NVIC_DisableIRQ(sci->interupt);
+        rings->tx = (struct sci_ring_s){
+            .data = (buffers->tx_size > 1) ? buffers->tx_data : NULL,
+            .size = buffers->tx_size,
+            .mark = buffers->tx_low_water,
+        };
+        rings->rx = (struct sci_ring_s){
+            .data = (buffers->rx_size > 1) ? buffers->rx_data : NULL,
+            .size = buffers->rx_size,
+            .mark = buffers->rx_high_water,
+        };
+        SciEnableInterrupts(sci);
+        result = true;
+    }
+    return result;
+}
+
 uint16_t SciSendData(hal_sci_t sci, void const * const data, uint16_t size) {
     uint16_t result = 0;
     if (sci) {
-        result = Chip_UART_Send(sci->port, data, size);
+        sci_ring_t ring = &sci_buffers[sci->index].tx;
+
+        if (ring->data) {
+            // Every interrupt of the port drains the ring, receive ones included, so the whole
+            // port interrupt is off while the fifo is loaded and only one side drains the ring
+            NVIC_DisableIRQ(sci->interupt);
+            result = RingWrite(ring, data, size);
+            if (!sci_buffers[sci->index].block) {
+                RingTransmit(sci, ring);
+            }
+            NVIC_EnableIRQ(sci->interupt);
+        } else if (!sci_buffers[sci->index].block) {
+            result = Chip_UART_Send(sci->port, data, size);
+        }
+    }
+    return result;
+}
+
+uint16_t SciSendBlock(hal_sci_t sci, void const * const data, uint16_t size) {
+    uint16_t result = 0;
+    if (sci) {
+        sci_buffers_t buffers = &sci_buffers[sci->index];
+
+        if (size > SCI_DMA_MAX_BLOCK) {
+            size = SCI_DMA_MAX_BLOCK;
+        }
+        // The block goes after the data already in the ring, which is drained only by the
+        // interrupt, so an empty ring can't get data to the fifo until the block is over
+        if ((size > 0) && !buffers->block && (!buffers->tx.data || !RingCount(&buffers->tx))) {
+            // Chip_GPDMA_Init is not used because it stops the channels of other modules
+            Chip_Clock_EnableOpts(CLK_MX_DMA, true, true, 1);
+            NVIC_SetPriority(DMA_IRQn, HAL_SCI_NVIC_PRIORITY);
+            NVIC_EnableIRQ(DMA_IRQn);
+
+            buffers->block = true;
+            if (Chip_GPDMA_Transfer(LPC_GPDMA, sci->index, (uint32_t)data, sci->dma,
+                                    GPDMA_TRANSFERTYPE_M2P_CONTROLLER_DMA, size) == SUCCESS) {
+                result = size;
+            } else {
+                buffers->block = false;
+            }
+        }
     }
     return result;
 }
@@ -390,21 +681,25 @@ uint16_t SciSendData(hal_sci_t sci, void const * const data, uint16_t size) {
 uint16_t SciReceiveData(hal_sci_t sci, void * data, uint16_t size) {
     uint16_t result = 0;
     if (sci) {
-        result = Chip_UART_Read(sci->port, data, size);
+        sci_ring_t ring = &sci_buffers[sci->index].rx;
+
+        if (ring->data) {
+            result = RingRead(ring, data, size);
+        } else {
+            result = Chip_UART_Read(sci->port, data, size);
+        }
     }
     return result;
 }
 
 void SciReadStatus(hal_sci_t sci, sci_status_t result) {
     if (sci) {
-        uint32_t status = Chip_UART_ReadLineStatus(sci->port);
-        result->data_ready = status & UART_LSR_RDR;
-        result->overrun = status & UART_LSR_OE;
-        result->parity_error = status & UART_LSR_PE;
-        result->framing_error = status & UART_LSR_FE;
-        result->break_signal = status & UART_LSR_BI;
-        result->fifo_empty = status & UART_LSR_THRE;
-        result->tramition_completed = status & UART_LSR_TEMT;
+        sci_ring_t ring = &sci_buffers[sci->index].rx;
+
+        LineDecodeStatus(Chip_UART_ReadLineStatus(sci->port), result);
+        if (ring->data) {
+            result->data_ready = (RingCount(ring) > 0);
+        }
     }
 }
 
@@ -413,14 +708,7 @@ void SciSetEventHandler(hal_sci_t sci, hal_sci_event_t handler, void * data) {
         event_handler_t event_handler = &event_handlers[sci->index];
         event_handler->handler = handler;
         event_handler->data = data;
-
-        Chip_UART_ReadLineStatus(sci->port);
-        NVIC_ClearPendingIRQ(sci->interupt);
-        NVIC_SetPriority(sci->interupt, HAL_SCI_NVIC_PRIORITY);
-        NVIC_EnableIRQ(sci->interupt);
-        Chip_UART_IntEnable(sci->port, UART_IER_RBRINT);
-        Chip_UART_IntEnable(sci->port, UART_IER_THREINT);
-        Chip_UART_IntEnable(sci->port, UART_IER_RLSINT);
+        SciEnableInterrupts(sci);
     }
 }
 
@@ -440,6 +728,13 @@ void UART3_IRQHandler(void) {
     SciHandleEvent(HAL_SCI_USART3);
 }
 
+void DMA_IRQHandler(void) {
+    SciHandleBlock(HAL_SCI_USART0);
+    SciHandleBlock(HAL_SCI_UART1);
+    SciHandleBlock(HAL_SCI_USART2);
+    SciHandleBlock(HAL_SCI_USART3);
+}
+
 /* === End of documentation ==================================================================== */
 
 /** @} End of module definition for doxygen
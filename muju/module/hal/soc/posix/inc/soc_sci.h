@@ -29,6 +29,10 @@ SPDX-License-Identifier: MIT
 /** @file
  ** @brief Serial ports on posix declarations
  **
+ ** The event handlers run on the threads that emulate the port, outside of any kernel. They can
+ ** use the functions of this module, but not the functions of a kernel, not even the FromISR
+ ** ones, because the posix port of FreeRTOS only allows them from its own threads.
+ **
  ** @addtogroup posix Posix
  ** @ingroup hal
  ** @brief Posix SOC Hardware abstraction layer
@@ -50,8 +54,35 @@ extern "C" {
 
 /* === Public variable declarations ============================================================ */
 
+/** @cond !INTERNAL */
+extern const hal_sci_t HAL_SCI_POSIX0; /**< Constant to define emulated serial port 0 */
+extern const hal_sci_t HAL_SCI_POSIX1; /**< Constant to define emulated serial port 1 */
+/** @endcond */
+
 /* === Public function declarations ============================================================ */
 
+/**
+ * @brief Function to get the far end of the line of an emulated serial port
+ *
+ * The line is a pseudo-terminal in raw mode created by SciSetConfig. The port owns the master
+ * side, and this descriptor is the slave side: what the port sends is read from it, and what is
+ * written on it is received by the port. Both directions are paced at the configured baud rate.
+ *
+ * @param  sci      Pointer to the structure with the serial port descriptor
+ * @return int      File descriptor of the far end, -1 if the port is not configured
+ */
+int SciPosixPeer(hal_sci_t sci);
+
+/**
+ * @brief Function to get the device name of the far end of the line of an emulated serial port
+ *
+ * Any terminal program or test rig can open this device as if it was a real serial port.
+ *
+ * @param  sci          Pointer to the structure with the serial port descriptor
+ * @return const char*  Path of the slave side of the pseudo-terminal, NULL if not configured
+ */
+const char * SciPosixName(hal_sci_t sci);
+
 /* === End of documentation ==================================================================== */
 
 #ifdef __cplusplus
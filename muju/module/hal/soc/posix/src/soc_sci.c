@@ -34,42 +34,543 @@ SPDX-License-Identifier: MIT
 
 /* === Headers files inclusions =============================================================== */
 
+// Required by the pseudo-terminal functions of the C library
+#define _GNU_SOURCE
+
 #include "soc_sci.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdlib.h>
 #include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
 
 /* === Macros definitions ====================================================================== */
 
+/**
+ * @brief Macro with the amount of emulated serial ports
+ */
+#define SCI_POSIX_PORTS 2
+
+/**
+ * @brief Macro with the length of the emulated fifos on hardware, the same of the LPC43xx
+ */
+#define SCI_FIFO_SIZE 16
+
+/**
+ * @brief Macro with the nanoseconds to wait before looking again at a line nobody has open
+ */
+#define SCI_HANGUP_WAIT 10000000
+
 /* === Private data type declarations ========================================================== */
 
+/**
+ * @brief Strcuture to store a serial port descriptor
+ */
+struct hal_sci_s {
+    uint8_t index; /**< Numeric index of serial port */
+};
+
+/**
+ * @brief Structure to store a ring buffer shared between the emulated interrupts and a task
+ */
+typedef struct sci_ring_s {
+    uint8_t * data; /**< Memory of the ring, NULL when the ring is not in use */
+    uint16_t size;  /**< Length of the memory of the ring */
+    uint16_t mark;  /**< Pending data that raises the water event */
+    uint16_t head;  /**< Position to write the next data */
+    uint16_t tail;  /**< Position to read the next data */
+} * sci_ring_t;
+
+/**
+ * @brief Structure to store the state of the line of an emulated serial port
+ *
+ * The threads of the port play the part of the interrupts, and hold the lock while they run the
+ * event handler. The functions called from tasks take the same lock, as the drivers on hardware
+ * disable the interrupt of the port.
+ */
+typedef struct sci_line_s {
+    int line;                       /**< Master side of the pseudo-terminal, -1 if not configured */
+    int peer;                       /**< Slave side of the pseudo-terminal, the far end of line */
+    char name[64];                  /**< Device name of the slave side */
+    uint32_t character;             /**< Nanoseconds to transfer a character, zero to not pace */
+    pthread_mutex_t lock;           /**< Lock shared by emulated interrupts and calls from tasks */
+    pthread_cond_t transmit;        /**< Condition to wake up the transmission thread */
+    hal_sci_event_t handler;        /**< Function to call on the serial port events */
+    void * data;                    /**< User data sended as parameter in handler calls */
+    uint8_t output[SCI_FIFO_SIZE];  /**< Emulated output fifo on hardware */
+    uint8_t output_count;           /**< Amount of data in output fifo, including the line */
+    uint8_t input[SCI_FIFO_SIZE];   /**< Emulated input fifo on hardware */
+    uint8_t input_count;            /**< Amount of data in input fifo */
+    bool overrun;                   /**< Data was lost since the last status read */
+    struct sci_ring_s tx;           /**< Ring with data waiting to be put in output fifo */
+    struct sci_ring_s rx;           /**< Ring with data taken from input fifo */
+    uint8_t const * block;          /**< Block being sent by SciSendBlock, NULL when idle */
+    uint16_t block_size;            /**< Length of the block not yet sent */
+} * sci_line_t;
+
 /* === Private variable declarations =========================================================== */
 
 /* === Private function declarations =========================================================== */
 
+/**
+ * @brief Function to get the line of a configured serial port
+ *
+ * @param  sci          Pointer to the structure with the serial port descriptor
+ * @return sci_line_t   Pointer to the state of the line, NULL if the port is not configured
+ */
+static sci_line_t SciLine(hal_sci_t sci);
+
+/**
+ * @brief Function to get the amount of pending data in a ring
+ *
+ * @param  ring     Pointer to the structure with the ring
+ * @return uint16_t Amount of data written and not yet read
+ */
+static uint16_t RingCount(sci_ring_t ring);
+
+/**
+ * @brief Function to write data into a ring
+ *
+ * @param  ring     Pointer to the structure with the ring
+ * @param  data     Pointer to buffer with data to write
+ * @param  size     Length of data to write
+ * @return uint16_t Amount of data actually written
+ */
+static uint16_t RingWrite(sci_ring_t ring, uint8_t const * data, uint16_t size);
+
+/**
+ * @brief Function to read data from a ring
+ *
+ * @param  ring     Pointer to the structure with the ring
+ * @param  data     Pointer to the buffer to store data read
+ * @param  size     Length of data to read
+ * @return uint16_t Amount of data actually read
+ */
+static uint16_t RingRead(sci_ring_t ring, uint8_t * data, uint16_t size);
+
+/**
+ * @brief Function to move data from output ring to the free space of the output fifo
+ *
+ * @param  line     Pointer to the structure with the state of the line
+ */
+static void RingTransmit(sci_line_t line);
+
+/**
+ * @brief Function to wait the time that the line takes to transfer an amount of characters
+ *
+ * @param  line     Pointer to the structure with the state of the line
+ * @param  size     Amount of characters transferred
+ */
+static void Pace(sci_line_t line, uint16_t size);
+
+/**
+ * @brief Function to run an emulated interrupt, with the lock of the line taken
+ *
+ * @param  sci          Pointer to the structure with the serial port descriptor
+ * @param  fifo_empty   The output fifo got empty, as the THRE interrupt on hardware
+ * @param  block_sent   The block given to SciSendBlock was sent
+ */
+static void SciHandleEvent(hal_sci_t sci, bool fifo_empty, bool block_sent);
+
+/**
+ * @brief Function to implement a thread that puts the output fifo and the blocks on the line
+ *
+ * @param  object   Pointer to the structure with the serial port descriptor
+ * @return void*    Pointer to result data, required by function prototype, unused
+ */
+static void * TransmitThread(void * object);
+
+/**
+ * @brief Function to implement a thread that takes the data from the line to the input fifo
+ *
+ * @param  object   Pointer to the structure with the serial port descriptor
+ * @return void*    Pointer to result data, required by function prototype, unused
+ */
+static void * ReceiveThread(void * object);
+
 /* === Public variable definitions ============================================================= */
 
+/** Constant to define emulated serial port 0 */
+const hal_sci_t HAL_SCI_POSIX0 = &(struct hal_sci_s){.index = 0};
+
+/** Constant to define emulated serial port 1 */
+const hal_sci_t HAL_SCI_POSIX1 = &(struct hal_sci_s){.index = 1};
+
 /* === Private variable definitions ============================================================ */
 
+/**
+ * @brief Vector to store the lines of the serial ports
+ */
+static struct sci_line_s lines[SCI_POSIX_PORTS] = {
+    {.line = -1, .peer = -1},
+    {.line = -1, .peer = -1},
+};
+
 /* === Private function implementation ========================================================= */
 
+static sci_line_t SciLine(hal_sci_t sci) {
+    if (sci && (sci->index < SCI_POSIX_PORTS) && (lines[sci->index].line >= 0)) {
+        return &lines[sci->index];
+    }
+    return NULL;
+}
+
+static uint16_t RingCount(sci_ring_t ring) {
+    return ((uint32_t)ring->head + ring->size - ring->tail) % ring->size;
+}
+
+static uint16_t RingWrite(sci_ring_t ring, uint8_t const * data, uint16_t size) {
+    uint16_t head = ring->head;
+    uint16_t result = 0;
+
+    while (result < size) {
+        uint16_t next = (head + 1 == ring->size) ? 0 : head + 1;
+        if (next == ring->tail) {
+            break;
+        }
+        ring->data[head] = data[result++];
+        head = next;
+    }
+    ring->head = head;
+    return result;
+}
+
+static uint16_t RingRead(sci_ring_t ring, uint8_t * data, uint16_t size) {
+    uint16_t tail = ring->tail;
+    uint16_t result = 0;
+
+    while ((result < size) && (tail != ring->head)) {
+        data[result++] = ring->data[tail];
+        tail = (tail + 1 == ring->size) ? 0 : tail + 1;
+    }
+    ring->tail = tail;
+    return result;
+}
+
+static void RingTransmit(sci_line_t line) {
+    line->output_count += RingRead(&line->tx, &line->output[line->output_count],
+                                   SCI_FIFO_SIZE - line->output_count);
+    if (line->output_count) {
+        pthread_cond_signal(&line->transmit);
+    }
+}
+
+static void Pace(sci_line_t line, uint16_t size) {
+    uint64_t delay = (uint64_t)line->character * size;
+    struct timespec wait = {.tv_sec = delay / 1000000000, .tv_nsec = delay % 1000000000};
+
+    if (delay) {
+        nanosleep(&wait, NULL);
+    }
+}
+
+static void SciHandleEvent(hal_sci_t sci, bool fifo_empty, bool block_sent) {
+    sci_line_t line = &lines[sci->index];
+    struct sci_status_s status;
+    uint16_t pending;
+
+    SciReadStatus(sci, &status);
+    if (line->rx.data) {
+        status.rx_high_water = (RingCount(&line->rx) >= line->rx.mark);
+    }
+
+    if (line->block) {
+        status.tx_low_water = false;
+    } else if (line->tx.data) {
+        pending = RingCount(&line->tx);
+        RingTransmit(line);
+        status.tx_low_water = (pending > line->tx.mark) && (RingCount(&line->tx) <= line->tx.mark);
+    } else {
+        status.tx_low_water = fifo_empty;
+    }
+    status.block_sent = block_sent;
+
+    if (line->handler) {
+        line->handler(sci, &status, line->data);
+    }
+}
+
+static void * TransmitThread(void * object) {
+    hal_sci_t sci = object;
+    sci_line_t line = &lines[sci->index];
+    uint8_t data[SCI_FIFO_SIZE];
+    uint16_t size, sent;
+    bool from_block;
+    ssize_t written;
+    struct pollfd wait;
+
+    pthread_mutex_lock(&line->lock);
+    while (true) {
+        while ((line->output_count == 0) && (line->block == NULL)) {
+            pthread_cond_wait(&line->transmit, &line->lock);
+        }
+
+        // The fifo goes first, the DMA loads the block in the fifo after the data already there
+        from_block = (line->output_count == 0);
+        if (from_block) {
+            size = (line->block_size < SCI_FIFO_SIZE) ? line->block_size : SCI_FIFO_SIZE;
+            memcpy(data, line->block, size);
+        } else {
+            size = line->output_count;
+            memcpy(data, line->output, size);
+        }
+        pthread_mutex_unlock(&line->lock);
+
+        for (sent = 0; sent < size; sent += written) {
+            written = write(line->line, &data[sent], size - sent);
+            if (written < 0) {
+                written = 0;
+                wait = (struct pollfd){.fd = line->line, .events = POLLOUT};
+                if ((errno != EAGAIN) || (poll(&wait, 1, -1) < 0) ||
+                    (wait.revents & (POLLHUP | POLLERR))) {
+                    // Nobody has the far end open, the data is lost as with a loose cable
+                    break;
+                }
+            }
+        }
+        Pace(line, size);
+
+        pthread_mutex_lock(&line->lock);
+        if (from_block) {
+            line->block += size;
+            line->block_size -= size;
+            if (line->block_size == 0) {
+                line->block = NULL;
+                SciHandleEvent(sci, false, true);
+            }
+        } else {
+            // Data put in the fifo while these were on the line stays for the next round
+            line->output_count -= size;
+            memmove(line->output, &line->output[size], line->output_count);
+            if (line->output_count == 0) {
+                SciHandleEvent(sci, true, false);
+            }
+        }
+    }
+    return NULL;
+}
+
+static void * ReceiveThread(void * object) {
+    hal_sci_t sci = object;
+    sci_line_t line = &lines[sci->index];
+    uint8_t data[SCI_FIFO_SIZE];
+    ssize_t size;
+    uint16_t stored;
+    struct pollfd wait;
+
+    while (true) {
+        wait = (struct pollfd){.fd = line->line, .events = POLLIN};
+        poll(&wait, 1, -1);
+        size = read(line->line, data, sizeof(data));
+        if (size <= 0) {
+            if (wait.revents & (POLLHUP | POLLERR)) {
+                // Nobody has the far end open, there is nothing to read until it opens again
+                nanosleep(&(struct timespec){.tv_nsec = SCI_HANGUP_WAIT}, NULL);
+            }
+            continue;
+        }
+        Pace(line, size);
+
+        pthread_mutex_lock(&line->lock);
+        if (line->rx.data) {
+            stored = RingWrite(&line->rx, data, size);
+        } else {
+            stored = SCI_FIFO_SIZE - line->input_count;
+            stored = (size < stored) ? size : stored;
+            memcpy(&line->input[line->input_count], data, stored);
+            line->input_count += stored;
+        }
+        if (stored < size) {
+            line->overrun = true;
+        }
+        SciHandleEvent(sci, false, false);
+        pthread_mutex_unlock(&line->lock);
+    }
+    return NULL;
+}
+
 /* === Public function implementation ========================================================== */
 
-bool SciSetConfig(hal_sci_t sci, hal_sci_line_t line, hal_sci_pins_t pins) {
-    return false;
+bool SciSetConfig(hal_sci_t sci, hal_sci_line_t config, hal_sci_pins_t pins) {
+    bool result = false;
+
+    (void)pins; // the emulated lines have no pins to configure
+    if (sci && (sci->index < SCI_POSIX_PORTS)) {
+        sci_line_t line = &lines[sci->index];
+        pthread_mutexattr_t attributes;
+        pthread_t thread;
+        struct termios mode;
+        uint32_t bits;
+
+        if (line->line < 0) {
+            line->line = posix_openpt(O_RDWR | O_NOCTTY);
+            if ((line->line >= 0) && (grantpt(line->line) == 0) && (unlockpt(line->line) == 0) &&
+                (ptsname_r(line->line, line->name, sizeof(line->name)) == 0)) {
+                line->peer = open(line->name, O_RDWR | O_NOCTTY);
+            }
+            if (line->peer >= 0) {
+                tcgetattr(line->peer, &mode);
+                cfmakeraw(&mode);
+                tcsetattr(line->peer, TCSANOW, &mode);
+                fcntl(line->line, F_SETFL, fcntl(line->line, F_GETFL) | O_NONBLOCK);
+
+                // The handler can read the port from inside the event, so the lock is recursive
+                pthread_mutexattr_init(&attributes);
+                pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE);
+                pthread_mutex_init(&line->lock, &attributes);
+                pthread_mutexattr_destroy(&attributes);
+                pthread_cond_init(&line->transmit, NULL);
+                pthread_create(&thread, NULL, TransmitThread, sci);
+                pthread_detach(thread);
+                pthread_create(&thread, NULL, ReceiveThread, sci);
+                pthread_detach(thread);
+            } else if (line->line >= 0) {
+                close(line->line);
+                line->line = -1;
+            }
+        }
+
+        if (line->line >= 0) {
+            // A start bit, the data bits, the parity bit and a stop bit for each character
+            pthread_mutex_lock(&line->lock);
+            line->character = 0;
+            if (config && config->baud_rate) {
+                bits = 2 + config->data_bits + ((config->parity != HAL_SCI_NO_PARITY) ? 1 : 0);
+                line->character = 1000000000ull * bits / config->baud_rate;
+            }
+            pthread_mutex_unlock(&line->lock);
+            result = true;
+        }
+    }
+    return result;
+}
+
+bool SciSetBuffers(hal_sci_t sci, hal_sci_buffers_t buffers) {
+    bool result = false;
+
+    sci_line_t line = SciLine(sci);
+
+    if (line) {
+        pthread_mutex_lock(&line->lock);
+        line->tx = (struct sci_ring_s){
+            .data = (buffers->tx_size > 1) ? buffers->tx_data : NULL,
+            .size = buffers->tx_size,
+            .mark = buffers->tx_low_water,
+        };
+        line->rx = (struct sci_ring_s){
+            .data = (buffers->rx_size > 1) ? buffers->rx_data : NULL,
+            .size = buffers->rx_size,
+            .mark = buffers->rx_high_water,
+        };
+        pthread_mutex_unlock(&line->lock);
+        result = true;
+    }
+    return result;
 }
 
 uint16_t SciSendData(hal_sci_t sci, void const * const data, uint16_t size) {
-    return size;
+    uint16_t result = size;
+
+    sci_line_t line = SciLine(sci);
+
+    // A port without a line discards the data, as the stub did before there were lines
+    if (line) {
+        pthread_mutex_lock(&line->lock);
+        if (line->tx.data) {
+            result = RingWrite(&line->tx, data, size);
+            if (!line->block && (line->output_count == 0)) {
+                RingTransmit(line);
+            }
+        } else if (!line->block) {
+            result = SCI_FIFO_SIZE - line->output_count;
+            result = (size < result) ? size : result;
+            memcpy(&line->output[line->output_count], data, result);
+            line->output_count += result;
+            pthread_cond_signal(&line->transmit);
+        } else {
+            result = 0;
+        }
+        pthread_mutex_unlock(&line->lock);
+    }
+    return result;
+}
+
+uint16_t SciSendBlock(hal_sci_t sci, void const * const data, uint16_t size) {
+    uint16_t result = 0;
+    sci_line_t line = SciLine(sci);
+
+    if (line && (size > 0)) {
+        pthread_mutex_lock(&line->lock);
+        if (!line->block && (!line->tx.data || !RingCount(&line->tx))) {
+            line->block = data;
+            line->block_size = size;
+            pthread_cond_signal(&line->transmit);
+            result = size;
+        }
+        pthread_mutex_unlock(&line->lock);
+    }
+    return result;
 }
 
 uint16_t SciReceiveData(hal_sci_t sci, void * data, uint16_t size) {
-    return size;
+    uint16_t result = 0;
+    sci_line_t line = SciLine(sci);
+
+    if (line) {
+        pthread_mutex_lock(&line->lock);
+        if (line->rx.data) {
+            result = RingRead(&line->rx, data, size);
+        } else {
+            result = (size < line->input_count) ? size : line->input_count;
+            memcpy(data, line->input, result);
+            line->input_count -= result;
+            memmove(line->input, &line->input[result], line->input_count);
+        }
+        pthread_mutex_unlock(&line->lock);
+    }
+    return result;
 }
 
 void SciReadStatus(hal_sci_t sci, sci_status_t result) {
+    sci_line_t line = SciLine(sci);
+
     memset(result, 0, sizeof(*result));
+    if (line) {
+        pthread_mutex_lock(&line->lock);
+        result->data_ready = line->rx.data ? (RingCount(&line->rx) > 0) : (line->input_count > 0);
+        result->overrun = line->overrun;
+        line->overrun = false;
+        result->fifo_empty = (line->output_count == 0) && !line->block;
+        result->tramition_completed = result->fifo_empty;
+        pthread_mutex_unlock(&line->lock);
+    }
 }
 
 void SciSetEventHandler(hal_sci_t sci, hal_sci_event_t handler, void * data) {
+    sci_line_t line = SciLine(sci);
+
+    if (line) {
+        pthread_mutex_lock(&line->lock);
+        line->handler = handler;
+        line->data = data;
+        pthread_mutex_unlock(&line->lock);
+    }
+}
+
+int SciPosixPeer(hal_sci_t sci) {
+    sci_line_t line = SciLine(sci);
+
+    return line ? line->peer : -1;
+}
+
+const char * SciPosixName(hal_sci_t sci) {
+    sci_line_t line = SciLine(sci);
+
+    return line ? line->name : NULL;
 }
 
 /* === End of documentation ==================================================================== */
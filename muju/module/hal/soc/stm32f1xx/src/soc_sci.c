@@ -62,9 +62,12 @@ SPDX-License-Identifier: MIT
  * @brief Strcuture to store a serial port descriptor
  */
 struct hal_sci_s {
-    USART_TypeDef * port; /**< Pointer to the memory area with the serial port registers */
-    IRQn_Type interupt;   /**< Interrupt number corresponding to the serial port */
-    uint8_t index;        /**< Numeric index of serial port */
+    USART_TypeDef * port;      /**< Pointer to the memory area with the serial port registers */
+    IRQn_Type interupt;        /**< Interrupt number corresponding to the serial port */
+    uint8_t index;             /**< Numeric index of serial port */
+    DMA_Channel_TypeDef * dma; /**< DMA1 channel wired to the transmission of the serial port */
+    IRQn_Type dma_interupt;    /**< Interrupt number corresponding to the DMA1 channel */
+    uint8_t dma_flags;         /**< Position of the flags of the channel in DMA1 registers */
 };
 
 /**
@@ -75,6 +78,26 @@ typedef struct event_handler_s {
     void * data;             /**< Pointer to user data sended as parameter in handler calls */
 } * event_handler_t;
 
+/**
+ * @brief Structure to store a ring buffer shared between the serial port interrupt and a task
+ */
+typedef struct sci_ring_s {
+    uint8_t * data;         /**< Memory of the ring, NULL when the ring is not in use */
+    uint16_t size;          /**< Length of the memory of the ring */
+    uint16_t mark;          /**< Pending data that raises the water event */
+    volatile uint16_t head; /**< Position to write the next data, only moved by the producer */
+    volatile uint16_t tail; /**< Position to read the next data, only moved by the consumer */
+} * sci_ring_t;
+
+/**
+ * @brief Structure to store the rings of a serial port
+ */
+typedef struct sci_buffers_s {
+    struct sci_ring_s tx; /**< Ring with data waiting to be put in output register */
+    struct sci_ring_s rx; /**< Ring with data taken from input register */
+    volatile bool block;  /**< A block is being sent by DMA, the output ring waits for it */
+} * sci_buffers_t;
+
 /* === Private variable declarations =========================================================== */
 
 /* === Private function declarations ===========================================================  */
@@ -116,6 +139,34 @@ static bool ConfigPinsUsart3(hal_sci_pins_t pins);
  */
 static bool LineEncodeBits(hal_sci_line_t line, UART_InitTypeDef * config);
 
+/**
+ * @brief Function to get the amount of pending data in a ring
+ *
+ * @param  ring     Pointer to the structure with the ring
+ * @return uint16_t Amount of data written and not yet read
+ */
+static uint16_t RingCount(sci_ring_t ring);
+
+/**
+ * @brief Function to write data into a ring
+ *
+ * @param  ring     Pointer to the structure with the ring
+ * @param  data     Pointer to buffer with data to write
+ * @param  size     Length of data to write
+ * @return uint16_t Amount of data actually written
+ */
+static uint16_t RingWrite(sci_ring_t ring, uint8_t const * data, uint16_t size);
+
+/**
+ * @brief Function to read data from a ring
+ *
+ * @param  ring     Pointer to the structure with the ring
+ * @param  data     Pointer to the buffer to store data read
+ * @param  size     Length of data to read
+ * @return uint16_t Amount of data actually read
+ */
+static uint16_t RingRead(sci_ring_t ring, uint8_t * data, uint16_t size);
+
 /**
  * @brief Function to dispatch an sci port event when the device raises an interrupt
  *
@@ -123,6 +174,13 @@ static bool LineEncodeBits(hal_sci_line_t line, UART_InitTypeDef * config);
  */
 static void SciHandleEvent(hal_sci_t sci);
 
+/**
+ * @brief Function to dispatch the end of a block when the DMA1 channel raises an interrupt
+ *
+ * @param  sci  Pointer to the structure with the serial port descriptor
+ */
+static void SciHandleBlock(hal_sci_t sci);
+
 /* === Public variable definitions ============================================================= */
 
 /**
@@ -132,16 +190,19 @@ static void SciHandleEvent(hal_sci_t sci);
  */
 
 /** Constant to define serial port 1 */
-const hal_sci_t HAL_SCI_USART1 =
-    &(struct hal_sci_s){.port = USART1, .interupt = USART1_IRQn, .index = 0};
+const hal_sci_t HAL_SCI_USART1 = &(struct hal_sci_s){
+    .port = USART1, .interupt = USART1_IRQn, .index = 0,
+    .dma = DMA1_Channel4, .dma_interupt = DMA1_Channel4_IRQn, .dma_flags = 12};
 
 /** Constant to define serial port 2 */
-const hal_sci_t HAL_SCI_USART2 =
-    &(struct hal_sci_s){.port = USART2, .interupt = USART2_IRQn, .index = 1};
+const hal_sci_t HAL_SCI_USART2 = &(struct hal_sci_s){
+    .port = USART2, .interupt = USART2_IRQn, .index = 1,
+    .dma = DMA1_Channel7, .dma_interupt = DMA1_Channel7_IRQn, .dma_flags = 24};
 
 /** Constant to define serial port 3 */
-const hal_sci_t HAL_SCI_USART3 =
-    &(struct hal_sci_s){.port = USART3, .interupt = USART3_IRQn, .index = 2};
+const hal_sci_t HAL_SCI_USART3 = &(struct hal_sci_s){
+    .port = USART3, .interupt = USART3_IRQn, .index = 2,
+    .dma = DMA1_Channel2, .dma_interupt = DMA1_Channel2_IRQn, .dma_flags = 4};
 
 /** @} End of group stmf32f1xx */
 
@@ -157,6 +218,11 @@ static struct event_handler_s event_handlers[4] = {0};
  */
 UART_HandleTypeDef usart_handlers[3];
 
+/**
+ * @brief Vector to store the rings of the serial ports
+ */
+static struct sci_buffers_s sci_buffers[3] = {0};
+
 /* === Private function implementation ========================================================= */
 
 static bool ConfigPinsUart1(hal_sci_pins_t pins) {
@@ -298,23 +364,114 @@ static bool LineEncodeBits(hal_sci_line_t line, UART_InitTypeDef * config) {
     return result;
 }
 
+static uint16_t RingCount(sci_ring_t ring) {
+    return ((uint32_t)ring->head + ring->size - ring->tail) % ring->size;
+}
+
+static uint16_t RingWrite(sci_ring_t ring, uint8_t const * data, uint16_t size) {
+    uint16_t head = ring->head;
+    uint16_t result = 0;
+
+    while (result < size) {
+        uint16_t next = (head + 1 == ring->size) ? 0 : head + 1;
+        if (next == ring->tail) {
+            break;
+        }
+        ring->data[head] = data[result++];
+        head = next;
+    }
+    ring->head = head;
+    return result;
+}
+
+static uint16_t RingRead(sci_ring_t ring, uint8_t * data, uint16_t size) {
+    uint16_t tail = ring->tail;
+    uint16_t result = 0;
+
+    while ((result < size) && (tail != ring->head)) {
+        data[result++] = ring->data[tail];
+        tail = (tail + 1 == ring->size) ? 0 : tail + 1;
+    }
+    ring->tail = tail;
+    return result;
+}
+
 static void SciHandleEvent(hal_sci_t sci) {
     if (sci) {
         event_handler_t event_handler = &event_handlers[sci->index];
+        sci_buffers_t buffers = &sci_buffers[sci->index];
+        UART_HandleTypeDef * handler = &usart_handlers[sci->index];
         struct sci_status_s status;
+        uint16_t pending;
+        uint8_t data;
 
         SciReadStatus(sci, &status);
+
+        if (buffers->rx.data) {
+            if (__HAL_UART_GET_FLAG(handler, UART_FLAG_RXNE)) {
+                data = (uint8_t)(sci->port->DR & 0xFF);
+                if (RingWrite(&buffers->rx, &data, 1) == 0) {
+                    status.overrun = true;
+                }
+            }
+            pending = RingCount(&buffers->rx);
+            status.data_ready = (pending > 0);
+            status.rx_high_water = (pending >= buffers->rx.mark);
+        }
+
+        if (buffers->block) {
+            __HAL_UART_DISABLE_IT(handler, UART_IT_TXE);
+        } else if (buffers->tx.data) {
+            // The register holds one byte, so each empty interrupt moves one byte from the ring
+            pending = RingCount(&buffers->tx);
+            if (__HAL_UART_GET_FLAG(handler, UART_FLAG_TXE)) {
+                if (RingRead(&buffers->tx, &data, 1)) {
+                    sci->port->DR = data;
+                } else {
+                    __HAL_UART_DISABLE_IT(handler, UART_IT_TXE);
+                }
+            }
+            status.tx_low_water =
+                (pending > buffers->tx.mark) && (RingCount(&buffers->tx) <= buffers->tx.mark);
+        } else {
+            status.tx_low_water =
+                status.fifo_empty && __HAL_UART_GET_IT_SOURCE(handler, UART_IT_TXE);
+        }
+
         if (event_handler->handler) {
             event_handler->handler(sci, &status, event_handler->data);
         }
 
-        UART_HandleTypeDef * handler = &usart_handlers[sci->index];
-        if (__HAL_UART_GET_FLAG(handler, UART_FLAG_TXE)) {
+        if (!buffers->tx.data && __HAL_UART_GET_FLAG(handler, UART_FLAG_TXE)) {
             __HAL_UART_DISABLE_IT(handler, UART_IT_TXE);
         }
     }
 }
 
+static void SciHandleBlock(hal_sci_t sci) {
+    event_handler_t event_handler = &event_handlers[sci->index];
+    sci_buffers_t buffers = &sci_buffers[sci->index];
+    UART_HandleTypeDef * handler = &usart_handlers[sci->index];
+    struct sci_status_s status;
+
+    // The end and the error of the transfer both finish the block
+    if (DMA1->ISR & ((DMA_ISR_TCIF1 | DMA_ISR_TEIF1) << sci->dma_flags)) {
+        DMA1->IFCR = DMA_IFCR_CGIF1 << sci->dma_flags;
+        sci->dma->CCR = 0;
+        CLEAR_BIT(sci->port->CR3, USART_CR3_DMAT);
+        buffers->block = false;
+
+        SciReadStatus(sci, &status);
+        if (buffers->tx.data && RingCount(&buffers->tx)) {
+            __HAL_UART_ENABLE_IT(handler, UART_IT_TXE);
+        }
+        status.block_sent = true;
+        if (event_handler->handler) {
+            event_handler->handler(sci, &status, event_handler->data);
+        }
+    }
+}
+
 /* === Public function implementation ========================================================== */
 
 bool SciSetConfig(hal_sci_t sci, hal_sci_line_t line, hal_sci_pins_t pins) {
@@ -348,18 +505,83 @@ bool SciSetConfig(hal_sci_t sci, hal_sci_line_t line, hal_sci_pins_t pins) {
     return result;
 }
 
+bool SciSetBuffers(hal_sci_t sci, hal_sci_buffers_t buffers) {
+    bool result = false;
+
+    if (sci) {
+        sci_buffers_t rings = &sci_buffers[sci->index];
+        UART_HandleTypeDef * handler = &usart_handlers[sci->index];
+
+        NVIC_DisableIRQ(sci->interupt);
+        rings->tx = (struct sci_ring_s){
+            .data = (buffers->tx_size > 1) ? buffers->tx_data : NULL,
+            .size = buffers->tx_size,
+            .mark = buffers->tx_low_water,
+        };
+        rings->rx = (struct sci_ring_s){
+            .data = (buffers->rx_size > 1) ? buffers->rx_data : NULL,
+            .size = buffers->rx_size,
+            .mark = buffers->rx_high_water,
+        };
+
+        NVIC_ClearPendingIRQ(sci->interupt);
+        NVIC_SetPriority(sci->interupt, HAL_SCI_NVIC_PRIORITY);
+        NVIC_EnableIRQ(sci->interupt);
+        __HAL_UART_ENABLE_IT(handler, UART_IT_RXNE);
+        result = true;
+    }
+    return result;
+}
+
 uint16_t SciSendData(hal_sci_t sci, void const * const data, uint16_t size) {
     uint16_t result = 0;
     if (sci) {
         UART_HandleTypeDef * handler = &usart_handlers[sci->index];
         event_handler_t event_handler = &event_handlers[sci->index];
+        sci_ring_t ring = &sci_buffers[sci->index].tx;
 
-        HAL_UART_Transmit(handler, (uint8_t *)data, 1, 1);
-        result = 1;
+        if (ring->data) {
+            // The interrupt is off while the ring is written, it drains the ring once enabled
+            __HAL_UART_DISABLE_IT(handler, UART_IT_TXE);
+            result = RingWrite(ring, data, size);
+            if (!sci_buffers[sci->index].block) {
+                __HAL_UART_ENABLE_IT(handler, UART_IT_TXE);
+            }
+        } else if (!sci_buffers[sci->index].block) {
+            HAL_UART_Transmit(handler, (uint8_t *)data, 1, 1);
+            result = 1;
+
+            if ((result < size) && (event_handler->handler != NULL)) {
+                UART_HandleTypeDef * handler = &usart_handlers[sci->index];
+                __HAL_UART_ENABLE_IT(handler, UART_IT_TXE);
+            }
+        }
+    }
+    return result;
+}
 
-        if ((result < size) && (event_handler->handler != NULL)) {
-            UART_HandleTypeDef * handler = &usart_handlers[sci->index];
-            __HAL_UART_ENABLE_IT(handler, UART_IT_TXE);
+uint16_t SciSendBlock(hal_sci_t sci, void const * const data, uint16_t size) {
+    uint16_t result = 0;
+    if (sci) {
+        sci_buffers_t buffers = &sci_buffers[sci->index];
+
+        // The block goes after the data already in the ring, which is drained only by the
+        // interrupt, so an empty ring can't get data to the register until the block is over
+        if ((size > 0) && !buffers->block && (!buffers->tx.data || !RingCount(&buffers->tx))) {
+            __HAL_RCC_DMA1_CLK_ENABLE();
+            NVIC_ClearPendingIRQ(sci->dma_interupt);
+            NVIC_SetPriority(sci->dma_interupt, HAL_SCI_NVIC_PRIORITY);
+            NVIC_EnableIRQ(sci->dma_interupt);
+
+            buffers->block = true;
+            sci->dma->CCR = 0;
+            DMA1->IFCR = DMA_IFCR_CGIF1 << sci->dma_flags;
+            sci->dma->CPAR = (uint32_t)&sci->port->DR;
+            sci->dma->CMAR = (uint32_t)data;
+            sci->dma->CNDTR = size;
+            sci->dma->CCR = DMA_CCR_DIR | DMA_CCR_MINC | DMA_CCR_TCIE | DMA_CCR_TEIE | DMA_CCR_EN;
+            SET_BIT(sci->port->CR3, USART_CR3_DMAT);
+            result = size;
         }
     }
     return result;
@@ -369,9 +591,14 @@ uint16_t SciReceiveData(hal_sci_t sci, void * data, uint16_t size) {
     uint16_t result = 0;
     if (sci) {
         UART_HandleTypeDef * handler = &usart_handlers[sci->index];
+        sci_ring_t ring = &sci_buffers[sci->index].rx;
 
-        HAL_UART_Receive(handler, (uint8_t *)data, 1, 1);
-        result = 1;
+        if (ring->data) {
+            result = RingRead(ring, data, size);
+        } else {
+            HAL_UART_Receive(handler, (uint8_t *)data, 1, 1);
+            result = 1;
+        }
     }
     return result;
 }
@@ -386,6 +613,12 @@ void SciReadStatus(hal_sci_t sci, sci_status_t result) {
         result->break_signal = __HAL_UART_GET_FLAG(handler, UART_FLAG_LBD);
         result->fifo_empty = __HAL_UART_GET_FLAG(handler, UART_FLAG_TXE);
         result->tramition_completed = __HAL_UART_GET_FLAG(handler, UART_FLAG_TC);
+        result->tx_low_water = false;
+        result->rx_high_water = false;
+        result->block_sent = false;
+        if (sci_buffers[sci->index].rx.data) {
+            result->data_ready = (RingCount(&sci_buffers[sci->index].rx) > 0);
+        }
     }
 }
 
@@ -417,6 +650,18 @@ void USART3_IRQHandler(void) {
     SciHandleEvent(HAL_SCI_USART3);
 }
 
+void DMA1_Channel2_IRQHandler(void) {
+    SciHandleBlock(HAL_SCI_USART3);
+}
+
+void DMA1_Channel4_IRQHandler(void) {
+    SciHandleBlock(HAL_SCI_USART1);
+}
+
+void DMA1_Channel7_IRQHandler(void) {
+    SciHandleBlock(HAL_SCI_USART2);
+}
+
 /* === End of documentation ==================================================================== */
 
 /** @} End of module definition for doxygen
@@ -0,0 +1,280 @@
+/************************************************************************************************
+Copyright (c) 2023, Emiliano Arnedo <emiarnedo@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** \brief Barrido de la pantalla por hardware
+ **
+ ** En el LPC43xx el match 0 del TIMER0 pide una rafaga al GPDMA en cada paso. El canal recorre una
+ ** lista enlazada circular con un descriptor por paso, que copia los valores del paso en los
+ ** registros MPIN de los puertos 0 a 5. Los registros MASK dejan afuera los bits que no son de la
+ ** pantalla, asi el DMA no pisa las otras salidas de esos puertos. El TIMER1 interrumpe una vez
+ ** por cada mitad del parpadeo para apuntar los descriptores a la otra tabla.
+ **
+ ** En posix un hilo hace el mismo recorrido sobre puertos emulados.
+ **
+ ** \addtogroup barrido Barrido
+ ** \brief Barrido de la pantalla por hardware
+ ** @{ */
+
+/* === Headers files inclusions =============================================================== */
+
+#include "barrido.h"
+#include <string.h>
+
+// En el LPC43xx solo se compila si se eligio el barrido por DMA, para no ocupar los timers ni el
+// canal de DMA cuando la pantalla la barre RefreshTask
+#if defined(LPC43XX) && defined(DISPLAY_SCAN_DMA)
+    #define BARRIDO_HARDWARE
+#endif
+
+#if defined(BARRIDO_HARDWARE)
+    #include "chip.h"
+#elif defined(POSIX)
+    #include <pthread.h>
+    #include <unistd.h>
+#endif
+
+/* === Macros definitions ====================================================================== */
+
+#if defined(BARRIDO_HARDWARE)
+    #define CANAL_BARRIDO  7           // canal de menor prioridad del GPDMA
+    #define TIMER_BARRIDO  LPC_TIMER0  // su match 0 es la linea de pedido GPDMA_CONN_MAT0_0
+    #define RELOJ_BARRIDO  CLK_MX_TIMER0
+    #define TIMER_PARPADEO LPC_TIMER1
+    #define MATCH_PASO     0
+#endif
+
+/* === Private data type declarations ========================================================== */
+
+/* === Private variable declarations =========================================================== */
+
+/* === Private function declarations =========================================================== */
+
+#if defined(BARRIDO_HARDWARE)
+static void Enlazar(uint8_t tabla);
+static void ArmarLista(void);
+#elif defined(POSIX)
+static void * HiloBarrido(void * object);
+#endif
+
+/* === Public variable definitions ============================================================= */
+
+/* === Private variable definitions ============================================================ */
+
+#if defined(BARRIDO_HARDWARE) || defined(POSIX)
+// Tabla 0: imagen encendida, tabla 1: imagen con los digitos que parpadean apagados
+static barrido_paso_t tablas[2][BARRIDO_MAX_PASOS];
+static uint8_t cantidad;
+static uint8_t fase;
+static uint16_t parpadeo;
+#endif
+
+#if defined(BARRIDO_HARDWARE)
+static DMA_TransferDescriptor_t lista[BARRIDO_MAX_PASOS];
+static uint32_t cuentas_paso; // cuentas del timer por cada paso
+
+#elif defined(POSIX)
+static pthread_t hilo;
+static pthread_mutex_t cerrojo = PTHREAD_MUTEX_INITIALIZER;
+static barrido_salida_t salida;
+static uint32_t periodo;
+static uint32_t mascaras[BARRIDO_PUERTOS];
+static uint32_t puertos[BARRIDO_PUERTOS];
+#endif
+
+/* === Private function implementation ========================================================= */
+
+#if defined(BARRIDO_HARDWARE)
+
+// Apunta cada descriptor a su paso en la tabla indicada. El DMA lee el descriptor recien al pasar
+// al paso siguiente, asi que el cambio no corta ningun paso a la mitad.
+static void Enlazar(uint8_t tabla) {
+    for (int i = 0; i < cantidad; i++) {
+        lista[i].src = (uint32_t)tablas[tabla][i];
+    }
+}
+
+static void ArmarLista(void) {
+    uint32_t control = GPDMA_DMACCxControl_TransferSize(BARRIDO_PUERTOS) |
+                       GPDMA_DMACCxControl_SBSize(GPDMA_BSIZE_8) |
+                       GPDMA_DMACCxControl_DBSize(GPDMA_BSIZE_8) |
+                       GPDMA_DMACCxControl_SWidth(GPDMA_WIDTH_WORD) |
+                       GPDMA_DMACCxControl_DWidth(GPDMA_WIDTH_WORD) | GPDMA_DMACCxControl_SI |
+                       GPDMA_DMACCxControl_DI;
+
+    LPC_GPDMA->CH[CANAL_BARRIDO].CONFIG = 0;
+    while (LPC_GPDMA->ENBLDCHNS & (1 << CANAL_BARRIDO)) {
+    }
+    if (cantidad == 0) {
+        return;
+    }
+
+    for (int i = 0; i < cantidad; i++) {
+        lista[i].dst = (uint32_t)&LPC_GPIO_PORT->MPIN[0];
+        lista[i].lli = (uint32_t)&lista[(i + 1) % cantidad];
+        lista[i].ctrl = control;
+    }
+    Enlazar(fase);
+
+    LPC_GPDMA->INTTCCLEAR = 1 << CANAL_BARRIDO;
+    LPC_GPDMA->INTERRCLR = 1 << CANAL_BARRIDO;
+    LPC_GPDMA->CH[CANAL_BARRIDO].SRCADDR = lista[0].src;
+    LPC_GPDMA->CH[CANAL_BARRIDO].DESTADDR = lista[0].dst;
+    LPC_GPDMA->CH[CANAL_BARRIDO].LLI = lista[0].lli;
+    LPC_GPDMA->CH[CANAL_BARRIDO].CONTROL = lista[0].ctrl;
+    // El destino es memoria pero se declara como periferico para que el timer marque el ritmo
+    LPC_GPDMA->CH[CANAL_BARRIDO].CONFIG =
+        GPDMA_DMACCxConfig_E | GPDMA_DMACCxConfig_DestPeripheral(GPDMA_CONN_MAT0_0) |
+        GPDMA_DMACCxConfig_TransferType(GPDMA_TRANSFERTYPE_M2P_CONTROLLER_DMA);
+}
+
+void TIMER1_IRQHandler(void) {
+    if (Chip_TIMER_MatchPending(TIMER_PARPADEO, 0)) {
+        Chip_TIMER_ClearMatch(TIMER_PARPADEO, 0);
+        fase ^= 1;
+        Enlazar(fase);
+    }
+}
+
+#elif defined(POSIX)
+
+static void * HiloBarrido(void * object) {
+    uint32_t copia[BARRIDO_PUERTOS];
+    uint8_t paso = 0;
+    uint16_t contador = 0;
+
+    (void)object;
+    while (true) {
+        usleep(periodo);
+        pthread_mutex_lock(&cerrojo);
+        if (cantidad) {
+            paso = (paso + 1) % cantidad;
+            if (parpadeo && ++contador >= parpadeo) {
+                contador = 0;
+                fase ^= 1;
+            }
+            for (int i = 0; i < BARRIDO_PUERTOS; i++) {
+                puertos[i] = (puertos[i] & ~mascaras[i]) | (tablas[fase][paso][i] & mascaras[i]);
+            }
+        }
+        memcpy(copia, puertos, sizeof(copia));
+        barrido_salida_t observador = salida;
+        pthread_mutex_unlock(&cerrojo);
+
+        if (observador) {
+            observador(copia);
+        }
+    }
+    return 0;
+}
+
+#endif
+
+/* === Public function implementation ========================================================== */
+
+#if defined(BARRIDO_HARDWARE)
+
+bool BarridoIniciar(uint32_t periodo_us, const uint32_t habilitados[BARRIDO_PUERTOS]) {
+    for (int i = 0; i < BARRIDO_PUERTOS; i++) {
+        Chip_GPIO_SetPortMask(LPC_GPIO_PORT, i, ~habilitados[i]);
+    }
+
+    Chip_GPDMA_Init(LPC_GPDMA);
+    // Linea de pedido 1 conectada al match 0 del TIMER0 (funcion 0 del multiplexor)
+    LPC_CREG->DMAMUX &= ~(0x03 << (2 * GPDMA_CONN_MAT0_0));
+
+    cuentas_paso = Chip_Clock_GetRate(RELOJ_BARRIDO) / 1000000 * periodo_us;
+    if (cuentas_paso == 0) {
+        return false;
+    }
+    Chip_TIMER_Init(TIMER_BARRIDO);
+    Chip_TIMER_Reset(TIMER_BARRIDO);
+    Chip_TIMER_SetMatch(TIMER_BARRIDO, MATCH_PASO, cuentas_paso - 1);
+    Chip_TIMER_ResetOnMatchEnable(TIMER_BARRIDO, MATCH_PASO);
+    Chip_TIMER_Enable(TIMER_BARRIDO);
+
+    Chip_TIMER_Init(TIMER_PARPADEO);
+    NVIC_EnableIRQ(TIMER1_IRQn);
+
+    return true;
+}
+
+void BarridoCargar(const barrido_paso_t * encendido, const barrido_paso_t * apagado, uint8_t pasos,
+                   uint16_t pasos_parpadeo) {
+    if (pasos > BARRIDO_MAX_PASOS) {
+        pasos = BARRIDO_MAX_PASOS;
+    }
+    // Si el DMA lee un paso mientras se copia, ese paso se ve mezclado durante un solo periodo
+    memcpy(tablas[0], encendido, pasos * sizeof(barrido_paso_t));
+    memcpy(tablas[1], apagado, pasos * sizeof(barrido_paso_t));
+
+    NVIC_DisableIRQ(TIMER1_IRQn);
+    if (pasos != cantidad) {
+        cantidad = pasos;
+        ArmarLista();
+    }
+    if (pasos_parpadeo != parpadeo) {
+        parpadeo = pasos_parpadeo;
+        Chip_TIMER_Disable(TIMER_PARPADEO);
+        Chip_TIMER_Reset(TIMER_PARPADEO);
+        Chip_TIMER_ClearMatch(TIMER_PARPADEO, 0);
+        fase = 0;
+        Enlazar(fase);
+        if (parpadeo) {
+            Chip_TIMER_SetMatch(TIMER_PARPADEO, 0, cuentas_paso * parpadeo - 1);
+            Chip_TIMER_ResetOnMatchEnable(TIMER_PARPADEO, 0);
+            Chip_TIMER_MatchEnableInt(TIMER_PARPADEO, 0);
+            Chip_TIMER_Enable(TIMER_PARPADEO);
+        }
+    }
+    NVIC_EnableIRQ(TIMER1_IRQn);
+}
+
+#elif defined(POSIX)
+
+bool BarridoIniciar(uint32_t periodo_us, const uint32_t habilitados[BARRIDO_PUERTOS]) {
+    periodo = periodo_us;
+    memcpy(mascaras, habilitados, sizeof(mascaras));
+    return pthread_create(&hilo, NULL, HiloBarrido, NULL) == 0;
+}
+
+void BarridoCargar(const barrido_paso_t * encendido, const barrido_paso_t * apagado, uint8_t pasos,
+                   uint16_t pasos_parpadeo) {
+    if (pasos > BARRIDO_MAX_PASOS) {
+        pasos = BARRIDO_MAX_PASOS;
+    }
+    pthread_mutex_lock(&cerrojo);
+    memcpy(tablas[0], encendido, pasos * sizeof(barrido_paso_t));
+    memcpy(tablas[1], apagado, pasos * sizeof(barrido_paso_t));
+    cantidad = pasos;
+    if (pasos_parpadeo != parpadeo) {
+        parpadeo = pasos_parpadeo;
+        fase = 0;
+    }
+    pthread_mutex_unlock(&cerrojo);
+}
+
+void BarridoObservar(barrido_salida_t funcion) {
+    pthread_mutex_lock(&cerrojo);
+    salida = funcion;
+    pthread_mutex_unlock(&cerrojo);
+}
+
+#endif
+
+/* === End of documentation ==================================================================== */
+
+/** @} End of module definition for doxygen */
@@ -30,6 +30,8 @@ SPDX-License-Identifier: MIT
 #include "bsp.h"
 #include "poncho.h"
 #include "board.h"
+#include "barrido.h"
+#include <string.h>
 
 /* === Macros definitions ====================================================================== */
 //! Cantidad de digitos que se crearan
@@ -37,13 +39,40 @@ SPDX-License-Identifier: MIT
     #define DIGITOS 4
 #endif // DIGITOS
 
+//! Duracion en microsegundos de cada digito cuando la pantalla se barre por hardware
+#if !defined(DISPLAY_SCAN_PERIOD_US)
+    #define DISPLAY_SCAN_PERIOD_US 1000
+#endif
+
+//! Capacidad de los buffers circulares de la consola
+#if !defined(CONSOLE_TX_BUFFER)
+    #define CONSOLE_TX_BUFFER 256
+#endif
+#if !defined(CONSOLE_RX_BUFFER)
+    #define CONSOLE_RX_BUFFER 16
+#endif
+
 /* === Private data type declarations ========================================================== */
 
 /* === Private variable declarations =========================================================== */
 
+#if defined(DISPLAY_SCAN_MASKED)
+// Valor del puerto de digitos para cada digito, en el mismo orden que DigitTurnOn sin mascaras
+static const uint32_t DIGIT_PATTERNS[DIGITOS] = {
+    (8 >> 0) & DIGITS_MASK,
+    (8 >> 1) & DIGITS_MASK,
+    (8 >> 2) & DIGITS_MASK,
+    (8 >> 3) & DIGITS_MASK,
+};
+#endif
+
 static board_s board = {0};
 display_driver_t driver;
 
+// Buffers que vacia y llena la interrupcion de la consola. La salida avisa con un cuarto libre.
+static uint8_t console_tx[CONSOLE_TX_BUFFER];
+static uint8_t console_rx[CONSOLE_RX_BUFFER];
+
 /* === Private function declarations =========================================================== */
 void digits_init(void);
 void segments_init(void);
@@ -52,6 +81,11 @@ void keys_init(void);
 void ScreenTurnOff(void);
 void SegmentsTurnOn(uint8_t segments);
 void DigitTurnOn(uint8_t digits);
+#if defined(DISPLAY_SCAN_DMA)
+static void ScanStep(barrido_paso_t paso, uint8_t digit, uint8_t segments);
+static void ScanFrames(const uint8_t * frame_on, const uint8_t * frame_off, uint8_t digits,
+                       uint16_t flashing_steps);
+#endif
 /* === Public variable definitions ============================================================= */
 
 /* === Private variable definitions ============================================================ */
@@ -150,6 +184,26 @@ void keys_init(void) {
     board.increment = DigitalInputCreate(KEY_F4_GPIO, KEY_F4_BIT, false);
 }
 
+#if defined(DISPLAY_SCAN_MASKED)
+// Con los registros MASK cargados en BoardCreate cada puerto de la pantalla se escribe entero en
+// MPIN, en una sola escritura y sin tocar el resto de los pines del puerto. Alcanza con apagar
+// los digitos porque los segmentos no se ven hasta que se prende el proximo.
+void ScreenTurnOff(void) {
+
+    LPC_GPIO_PORT->MPIN[DIGITS_GPIO] = 0;
+}
+
+void SegmentsTurnOn(uint8_t segments) {
+
+    LPC_GPIO_PORT->MPIN[SEGMENTS_GPIO] = segments;
+    LPC_GPIO_PORT->MPIN[SEGMENT_P_GPIO] = (uint32_t)(segments & SEGMENT_P) << (SEGMENT_P_BIT - 7);
+}
+
+void DigitTurnOn(uint8_t digits) {
+
+    LPC_GPIO_PORT->MPIN[DIGITS_GPIO] = DIGIT_PATTERNS[digits];
+}
+#else
 void ScreenTurnOff(void) {
 
     Chip_GPIO_ClearValue(LPC_GPIO_PORT, DIGITS_GPIO, DIGITS_MASK);
@@ -168,6 +222,33 @@ void DigitTurnOn(uint8_t digits) {
     // En bitValue se utiliza 8 >> digits para invertir el orden en que se prenden los digitos
     Chip_GPIO_SetValue(LPC_GPIO_PORT, DIGITS_GPIO, (8 >> digits) & DIGITS_MASK);
 }
+#endif
+
+#if defined(DISPLAY_SCAN_DMA)
+// Arma el valor de cada puerto para un digito, con el mismo orden de digitos que DigitTurnOn
+static void ScanStep(barrido_paso_t paso, uint8_t digit, uint8_t segments) {
+
+    memset(paso, 0, sizeof(barrido_paso_t));
+    paso[DIGITS_GPIO] |= (8 >> digit) & DIGITS_MASK;
+    paso[SEGMENTS_GPIO] |= segments & SEGMENTS_MASK;
+    if (segments & SEGMENT_P) {
+        paso[SEGMENT_P_GPIO] |= 1 << SEGMENT_P_BIT;
+    }
+}
+
+static void ScanFrames(const uint8_t * frame_on, const uint8_t * frame_off, uint8_t digits,
+                       uint16_t flashing_steps) {
+
+    static barrido_paso_t on[BARRIDO_MAX_PASOS];
+    static barrido_paso_t off[BARRIDO_MAX_PASOS];
+
+    for (int i = 0; i < digits && i < BARRIDO_MAX_PASOS; i++) {
+        ScanStep(on[i], i, frame_on[i]);
+        ScanStep(off[i], i, frame_off[i]);
+    }
+    BarridoCargar(on, off, digits, flashing_steps);
+}
+#endif
 /* === Public function implementation ========================================================== */
 
 board_t BoardCreate(void) {
@@ -177,6 +258,46 @@ board_t BoardCreate(void) {
     buzzer_init();
     keys_init();
 
+    // Contador de ciclos del nucleo, para medir el barrido de la pantalla
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    board.console = NULL;
+    if (SciSetConfig(CONSOLE_SCI,
+                     &(struct hal_sci_line_s){
+                         .baud_rate = CONSOLE_BAUD_RATE,
+                         .data_bits = 8,
+                         .parity = HAL_SCI_NO_PARITY,
+                     },
+                     &(struct hal_sci_pins_s){
+                         .txd_pin = CONSOLE_TXD_PIN,
+                         .rxd_pin = CONSOLE_RXD_PIN,
+                     })) {
+        board.console = CONSOLE_SCI;
+        SciSetBuffers(CONSOLE_SCI, &(struct hal_sci_buffers_s){
+                                       .tx_data = console_tx,
+                                       .tx_size = sizeof(console_tx),
+                                       .tx_low_water = sizeof(console_tx) * 3 / 4,
+                                       .rx_data = console_rx,
+                                       .rx_size = sizeof(console_rx),
+                                       .rx_high_water = 1,
+                                   });
+    }
+
+#if defined(DISPLAY_SCAN_MASKED)
+    Chip_GPIO_SetPortMask(LPC_GPIO_PORT, DIGITS_GPIO, ~DIGITS_MASK);
+    Chip_GPIO_SetPortMask(LPC_GPIO_PORT, SEGMENTS_GPIO, ~SEGMENTS_MASK);
+    Chip_GPIO_SetPortMask(LPC_GPIO_PORT, SEGMENT_P_GPIO, ~(1 << SEGMENT_P_BIT));
+#endif
+#if defined(DISPLAY_SCAN_DMA)
+    BarridoIniciar(DISPLAY_SCAN_PERIOD_US, (const uint32_t[BARRIDO_PUERTOS]){
+                                               [DIGITS_GPIO] = DIGITS_MASK,
+                                               [SEGMENTS_GPIO] = SEGMENTS_MASK,
+                                               [SEGMENT_P_GPIO] = 1 << SEGMENT_P_BIT,
+                                           });
+#endif
+
     // Se hace asi para no tener que crear la estructura , ya que no se
     // volvera a usar esa variable. Solo se puede hacer por que display_driver_s es una
     // estructura constante.
@@ -184,10 +305,35 @@ board_t BoardCreate(void) {
                                                .ScreenTurnOff = ScreenTurnOff,
                                                .DigitTurnOn = DigitTurnOn,
                                                .SegmentsTurnOn = SegmentsTurnOn,
+#if defined(DISPLAY_SCAN_DMA)
+                                               .ScanFrames = ScanFrames,
+#endif
                                            });
 
     return &board;
 }
+
+void BoardKeysSetEventHandler(digital_input_event_t handler, void * object) {
+
+    DigitalInputSetEventHandler(board.accept, KEY_ACCEPT_HAL, handler, object);
+    DigitalInputSetEventHandler(board.cancel, KEY_CANCEL_HAL, handler, object);
+    DigitalInputSetEventHandler(board.set_time, KEY_F1_HAL, handler, object);
+    DigitalInputSetEventHandler(board.set_alarm, KEY_F2_HAL, handler, object);
+    DigitalInputSetEventHandler(board.decrement, KEY_F3_HAL, handler, object);
+    DigitalInputSetEventHandler(board.increment, KEY_F4_HAL, handler, object);
+}
+
+void BoardDisplayRefresh(board_t board) {
+
+    uint32_t inicio = DWT->CYCCNT;
+    DisplayRefresh(board->display);
+    uint32_t ciclos = DWT->CYCCNT - inicio;
+
+    board->refresh_cycles.last = ciclos;
+    if (ciclos > board->refresh_cycles.max) {
+        board->refresh_cycles.max = ciclos;
+    }
+}
 /*
 void SisTick_Init(uint16_t ticks) {
 
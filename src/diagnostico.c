@@ -0,0 +1,300 @@
+/************************************************************************************************
+Copyright (c) 2023, Emiliano Arnedo <emiarnedo@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** \brief Diagnostico del sistema operativo por el puerto serie
+ **
+ ** El kernel llama a DiagnosticoContador en cada cambio de contexto para acumular el tiempo de
+ ** cada tarea, y a DiagnosticoTareaEntrando para contar cuantas veces entra a ejecutar. En el
+ ** LPC43xx el contador es el TIMER3 corriendo libre a 1 MHz, y en el STM32F1 son el TIM2 y el
+ ** TIM3 encadenados, porque sus contadores son de 16 bits. En posix el kernel usa el contador
+ ** del port, y DiagnosticoContador lee el reloj monotonico para medir las frecuencias.
+ **
+ ** \addtogroup diagnostico Diagnostico
+ ** \brief Diagnostico del sistema operativo
+ ** @{ */
+
+/* === Headers files inclusions =============================================================== */
+
+#include "diagnostico.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+#if defined(LPC43XX)
+    #include "chip.h"
+#elif defined(STM32F1XX)
+    #include "stm32f1xx.h"
+#elif defined(POSIX)
+    #include <time.h>
+#endif
+
+/* === Macros definitions ====================================================================== */
+
+//! Cantidad de tareas que se pueden reportar
+#if !defined(DIAGNOSTICO_MAX_TAREAS)
+    #define DIAGNOSTICO_MAX_TAREAS 10
+#endif
+
+//! Cantidad de contadores de la aplicacion que se pueden agregar al reporte
+#if !defined(DIAGNOSTICO_MAX_CONTADORES)
+    #define DIAGNOSTICO_MAX_CONTADORES 8
+#endif
+
+//! Largo maximo del texto de un reporte, que se envia entero como un solo bloque
+#if !defined(DIAGNOSTICO_MAX_REPORTE)
+    #define DIAGNOSTICO_MAX_REPORTE 1024
+#endif
+
+//! Tiempo maximo en milisegundos que se espera lugar en la consola antes de descartar el texto
+#if !defined(DIAGNOSTICO_ESPERA_CONSOLA)
+    #define DIAGNOSTICO_ESPERA_CONSOLA 100
+#endif
+
+//! Indice de la notificacion con la que la interrupcion de la consola avisa que hay lugar
+#define NOTIFICACION_CONSOLA 1
+
+#if defined(LPC43XX)
+    #define TIMER_DIAGNOSTICO LPC_TIMER3
+    #define RELOJ_DIAGNOSTICO CLK_MX_TIMER3
+#endif
+
+/* === Private data type declarations ========================================================== */
+
+//! Valores acumulados en el reporte anterior, indexados por el numero de TCB de cada tarea
+typedef struct anterior_s {
+    uint32_t contador; // tiempo total de ejecucion que informa el kernel
+    uint32_t instante; // valor de DiagnosticoContador
+    uint32_t tiempo[DIAGNOSTICO_MAX_TAREAS + 1];
+    uint32_t entradas[DIAGNOSTICO_MAX_TAREAS + 1];
+} anterior_s;
+
+typedef struct contador_s {
+    const char * nombre;
+    const volatile uint32_t * valor;
+} contador_s;
+
+/* === Private variable declarations =========================================================== */
+
+/* === Private function declarations =========================================================== */
+
+static void Agregar(const char * formato, ...);
+
+/* === Public variable definitions ============================================================= */
+
+/* === Private variable definitions ============================================================ */
+
+// Veces que entro a ejecutar cada tarea. Los numeros de TCB empiezan en 1.
+static volatile uint32_t entradas[DIAGNOSTICO_MAX_TAREAS + 1];
+
+static anterior_s anterior;
+
+static contador_s contadores[DIAGNOSTICO_MAX_CONTADORES];
+static int cantidad_contadores;
+
+// Tarea suspendida en Enviar esperando lugar en la consola
+static TaskHandle_t esperando;
+
+// Texto del reporte en armado. Mientras el DMA lo envia no se puede modificar.
+static char reporte[DIAGNOSTICO_MAX_REPORTE];
+static int largo_reporte;
+
+/* === Private function implementation ========================================================= */
+
+// Agrega una linea al final del reporte. Si no entra, el reporte se corta.
+static void Agregar(const char * formato, ...) {
+    va_list argumentos;
+    int largo;
+
+    va_start(argumentos, formato);
+    largo = vsnprintf(&reporte[largo_reporte], sizeof(reporte) - largo_reporte, formato,
+                      argumentos);
+    va_end(argumentos);
+    if (largo > 0) {
+        largo_reporte += largo;
+        if (largo_reporte >= sizeof(reporte)) {
+            largo_reporte = sizeof(reporte) - 1;
+        }
+    }
+}
+
+/* === Public function implementation ========================================================== */
+
+void DiagnosticoIniciarContador(void) {
+#if defined(LPC43XX)
+    Chip_TIMER_Init(TIMER_DIAGNOSTICO);
+    Chip_TIMER_Reset(TIMER_DIAGNOSTICO);
+    Chip_TIMER_PrescaleSet(TIMER_DIAGNOSTICO,
+                           Chip_Clock_GetRate(RELOJ_DIAGNOSTICO) / DIAGNOSTICO_FRECUENCIA - 1);
+    Chip_TIMER_Enable(TIMER_DIAGNOSTICO);
+#elif defined(STM32F1XX)
+    uint32_t divisor = APBPrescTable[(RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos];
+    uint32_t reloj = SystemCoreClock >> divisor;
+
+    if (divisor != 0) {
+        reloj *= 2; // con el APB1 dividido los timers corren al doble de su reloj
+    }
+    RCC->APB1ENR |= RCC_APB1ENR_TIM2EN | RCC_APB1ENR_TIM3EN;
+    TIM2->PSC = reloj / DIAGNOSTICO_FRECUENCIA - 1;
+    TIM2->ARR = 0xFFFF;
+    TIM2->EGR = TIM_EGR_UG;    // carga el prescaler antes de encadenar el TIM3
+    TIM2->CR2 = TIM_CR2_MMS_1; // cada desborde sale como disparo
+    // El TIM3 cuenta los desbordes del TIM2 (ITR1) y guarda la parte alta del contador
+    TIM3->ARR = 0xFFFF;
+    TIM3->SMCR = TIM_SMCR_TS_0 | TIM_SMCR_SMS;
+    TIM3->CNT = 0;
+    TIM3->CR1 = TIM_CR1_CEN;
+    TIM2->CNT = 0;
+    TIM2->CR1 = TIM_CR1_CEN;
+#endif
+}
+
+uint32_t DiagnosticoContador(void) {
+#if defined(LPC43XX)
+    return Chip_TIMER_ReadCount(TIMER_DIAGNOSTICO);
+#elif defined(STM32F1XX)
+    uint32_t alta, baja;
+
+    // La parte alta se vuelve a leer por si la baja desbordo entre las dos lecturas
+    do {
+        alta = TIM3->CNT;
+        baja = TIM2->CNT;
+    } while (alta != TIM3->CNT);
+    return (alta << 16) | baja;
+#elif defined(POSIX)
+    struct timespec ahora;
+
+    clock_gettime(CLOCK_MONOTONIC, &ahora);
+    return ahora.tv_sec * DIAGNOSTICO_FRECUENCIA +
+           ahora.tv_nsec / (1000000000 / DIAGNOSTICO_FRECUENCIA);
+#else
+    return 0;
+#endif
+}
+
+void DiagnosticoTareaEntrando(uint32_t numero) {
+    if (numero <= DIAGNOSTICO_MAX_TAREAS) {
+        entradas[numero]++;
+    }
+}
+
+bool DiagnosticoAgregarContador(const char * nombre, const volatile uint32_t * valor) {
+    if (cantidad_contadores >= DIAGNOSTICO_MAX_CONTADORES) {
+        return false;
+    }
+    contadores[cantidad_contadores].nombre = nombre;
+    contadores[cantidad_contadores].valor = valor;
+    cantidad_contadores++;
+    return true;
+}
+
+bool DiagnosticoConsolaLibre(void) {
+    BaseType_t despertar = pdFALSE;
+
+    if (esperando) {
+        vTaskNotifyGiveIndexedFromISR(esperando, NOTIFICACION_CONSOLA, &despertar);
+    }
+    return despertar == pdTRUE;
+}
+
+// Si el puerto lo acepta, el texto sale como un bloque por DMA y la tarea queda suspendida hasta
+// que termina, porque el texto no se puede tocar mientras tanto. Si no, se copia en la salida y
+// la tarea espera que la interrupcion la vacie hasta la marca baja; si no hay lugar en
+// DIAGNOSTICO_ESPERA_CONSOLA el resto del texto se descarta.
+void DiagnosticoEnviar(hal_sci_t consola, const void * datos, int largo) {
+    const uint8_t * texto = datos;
+    const TickType_t espera = pdMS_TO_TICKS(DIAGNOSTICO_ESPERA_CONSOLA);
+    uint16_t enviados;
+
+    esperando = xTaskGetCurrentTaskHandle();
+    while (largo > 0) {
+        // Un aviso viejo de la marca baja no se puede tomar como el fin del bloque
+        ulTaskNotifyValueClearIndexed(NULL, NOTIFICACION_CONSOLA, UINT32_MAX);
+        enviados = SciSendBlock(consola, texto, largo);
+        if (enviados > 0) {
+            // El puerto avisa el fin del bloque aunque la transferencia falle
+            ulTaskNotifyTakeIndexed(NOTIFICACION_CONSOLA, pdTRUE, portMAX_DELAY);
+        } else {
+            enviados = SciSendData(consola, texto, largo);
+            if ((enviados < largo) &&
+                (ulTaskNotifyTakeIndexed(NOTIFICACION_CONSOLA, pdTRUE, espera) == 0)) {
+                break;
+            }
+        }
+        texto += enviados;
+        largo -= enviados;
+    }
+}
+
+void DiagnosticoReportar(hal_sci_t consola) {
+    static TaskStatus_t tareas[DIAGNOSTICO_MAX_TAREAS];
+    uint32_t contador, transcurrido, instante, intervalo, tiempo, veces, milesimos;
+    UBaseType_t cantidad;
+
+    cantidad = uxTaskGetSystemState(tareas, DIAGNOSTICO_MAX_TAREAS, &contador);
+    transcurrido = contador - anterior.contador;
+    anterior.contador = contador;
+    if (transcurrido == 0) {
+        transcurrido = 1;
+    }
+    instante = DiagnosticoContador();
+    intervalo = instante - anterior.instante;
+    anterior.instante = instante;
+    if (intervalo == 0) {
+        intervalo = 1;
+    }
+
+    largo_reporte = 0;
+    Agregar("\r\n%-16s %6s %6s %8s\r\n", "Tarea", "CPU%", "Pila", "Entr/s");
+
+    // Los porcentajes y las frecuencias son desde el reporte anterior. Las restas sin signo
+    // siguen valiendo cuando el contador da la vuelta, cada 71 minutos.
+    for (int i = 0; i < cantidad; i++) {
+        UBaseType_t numero = tareas[i].xTaskNumber;
+        tiempo = 0;
+        veces = 0;
+        if (numero <= DIAGNOSTICO_MAX_TAREAS) {
+            tiempo = tareas[i].ulRunTimeCounter - anterior.tiempo[numero];
+            veces = entradas[numero] - anterior.entradas[numero];
+            anterior.tiempo[numero] = tareas[i].ulRunTimeCounter;
+            anterior.entradas[numero] += veces;
+        }
+        milesimos = (uint64_t)tiempo * 1000 / transcurrido;
+        Agregar("%-16s %4lu.%lu %6u %8lu\r\n", tareas[i].pcTaskName,
+                (unsigned long)(milesimos / 10), (unsigned long)(milesimos % 10),
+                (unsigned)tareas[i].usStackHighWaterMark,
+                (unsigned long)((uint64_t)veces * DIAGNOSTICO_FRECUENCIA / intervalo));
+    }
+
+#if defined(POSIX)
+    // En posix el heap es el de la biblioteca de C y no lleva estadisticas
+    Agregar("Heap del sistema\r\n");
+#else
+    Agregar("Heap libre %u, minimo %u\r\n", (unsigned)xPortGetFreeHeapSize(),
+            (unsigned)xPortGetMinimumEverFreeHeapSize());
+#endif
+
+    for (int i = 0; i < cantidad_contadores; i++) {
+        Agregar("%s %lu\r\n", contadores[i].nombre, (unsigned long)*contadores[i].valor);
+    }
+
+    DiagnosticoEnviar(consola, reporte, largo_reporte);
+}
+
+/* === End of documentation ==================================================================== */
+
+/** @} End of module definition for doxygen */
@@ -27,6 +27,8 @@ SPDX-License-Identifier: MIT
 
 #include "digital.h"
 #include "chip.h"
+#include "FreeRTOS.h"
+#include "timers.h"
 
 /* === Macros definitions ====================================================================== */
 // Si no esta definido OUTPUT_INSTANCES en algun otro archivo h, se lo define aqui.
@@ -36,26 +38,39 @@ SPDX-License-Identifier: MIT
 #ifndef INPUT_INSTANCES
     #define INPUT_INSTANCES 6
 #endif
+// Tiempo sin flancos que tiene que pasar para considerar estable una entrada por interrupciones
+#ifndef DEBOUNCE_MS
+    #define DEBOUNCE_MS 5
+#endif
 
 /* === Private data type declarations ========================================================== */
+// Cada terminal guarda la direccion de su registro de byte del GPIO (B[puerto][terminal]), que se
+// calcula al crearlo. Leer o escribir el nivel es un solo acceso, sin calcular la direccion ni
+// pasar por las funciones del chip en cada llamada.
 struct digital_output_s {
-    uint8_t port;
-    uint8_t pin;
+    volatile uint8_t * state;
     bool allocated : 1;
 };
 
 struct digital_input_s {
-    uint8_t port;
-    uint8_t pin;
+    volatile uint8_t * state;
     bool allocated : 1;
     bool inverted : 1;
     bool last_change : 1;
+    TimerHandle_t debounce;
+#if defined(STATIC_ALLOCATION)
+    StaticTimer_t debounce_memory;
+#endif
+    digital_input_event_t handler;
+    void * object;
 };
 /* === Private variable declarations =========================================================== */
 
 /* === Private function declarations =========================================================== */
 digital_output_t DigitalOutputAllocate(void);
 digital_input_t DigitalInputAllocate(void);
+static void DigitalInputEdge(hal_gpio_bit_t gpio, bool rising, void * object);
+static void DigitalInputDebounced(TimerHandle_t timer);
 /* === Public variable definitions ============================================================= */
 
 /* === Private variable definitions ============================================================ */
@@ -89,32 +104,53 @@ digital_input_t DigitalInputAllocate() {
     return input;
 }
 
+// Se ejecuta en la interrupcion del terminal: solo reinicia la espera del antirrebote
+static void DigitalInputEdge(hal_gpio_bit_t gpio, bool rising, void * object) {
+    digital_input_t input = object;
+    BaseType_t higher_priority_woken = pdFALSE;
+
+    xTimerResetFromISR(input->debounce, &higher_priority_woken);
+    portYIELD_FROM_ISR(higher_priority_woken);
+}
+
+static void DigitalInputDebounced(TimerHandle_t timer) {
+    digital_input_t input = pvTimerGetTimerID(timer);
+
+    bool current_state = DigitalInputGetState(input);
+    if (current_state != input->last_change) {
+        input->last_change = current_state;
+        input->handler(input, current_state, input->object);
+    }
+}
+
 /* === Public function implementation ========================================================== */
 /* --------------------------SALIDAS-------------------------- */
 digital_output_t DigitalOutputCreate(uint8_t port, uint8_t pin) {
 
     digital_output_t output = DigitalOutputAllocate();
-    output->port = port;
-    output->pin = pin;
-    Chip_GPIO_SetPinState(LPC_GPIO_PORT, output->port, output->pin, false);
-    Chip_GPIO_SetPinDIR(LPC_GPIO_PORT, output->port, output->pin, true);
+    if (output) {
+        output->state = &LPC_GPIO_PORT->B[port][pin];
+        *output->state = false;
+        Chip_GPIO_SetPinDIR(LPC_GPIO_PORT, port, pin, true);
+    }
 
     return output;
 }
 
+// Cada salida la maneja una sola tarea, asi que leer y escribir el nivel no necesita ser atomico
 void DigitalOutputToggle(digital_output_t output) {
 
-    Chip_GPIO_SetPinToggle(LPC_GPIO_PORT, output->port, output->pin);
+    *output->state = !*output->state;
 }
 
 void DigitalOutputActivate(digital_output_t output) {
 
-    Chip_GPIO_SetPinState(LPC_GPIO_PORT, output->port, output->pin, true);
+    *output->state = true;
 }
 
 void DigitalOutputDeactivate(digital_output_t output) {
 
-    Chip_GPIO_SetPinState(LPC_GPIO_PORT, output->port, output->pin, false);
+    *output->state = false;
 }
 
 /* --------------------------ENTRADAS-------------------------- */
@@ -123,10 +159,9 @@ digital_input_t DigitalInputCreate(uint8_t port, uint8_t pin, bool inverted) {
 
     digital_input_t input = DigitalInputAllocate();
     if (input) { // si es una direccion valida será true, si es NULL false
-        input->pin = pin;
-        input->port = port;
+        input->state = &LPC_GPIO_PORT->B[port][pin];
         input->inverted = inverted;
-        Chip_GPIO_SetPinDIR(LPC_GPIO_PORT, input->port, input->pin, false);
+        Chip_GPIO_SetPinDIR(LPC_GPIO_PORT, port, pin, false);
     }
 
     return input;
@@ -134,7 +169,7 @@ digital_input_t DigitalInputCreate(uint8_t port, uint8_t pin, bool inverted) {
 
 bool DigitalInputGetState(digital_input_t input) {
 
-    return input->inverted ^ Chip_GPIO_GetPinState(LPC_GPIO_PORT, input->port, input->pin);
+    return input->inverted ^ *input->state;
 }
 
 bool DigitalInputHasChanged(digital_input_t input) {
@@ -162,6 +197,29 @@ bool DigitalInputHasDeactivated(digital_input_t input) {
     return result;
 }
 
+bool DigitalInputSetEventHandler(digital_input_t input, hal_gpio_bit_t gpio,
+                                 digital_input_event_t handler, void * object) {
+
+    if (input->debounce == NULL) {
+#if defined(STATIC_ALLOCATION)
+        input->debounce = xTimerCreateStatic("Debounce", pdMS_TO_TICKS(DEBOUNCE_MS), pdFALSE, input,
+                                             DigitalInputDebounced, &input->debounce_memory);
+#else
+        input->debounce = xTimerCreate("Debounce", pdMS_TO_TICKS(DEBOUNCE_MS), pdFALSE, input,
+                                       DigitalInputDebounced);
+#endif
+    }
+    if (input->debounce == NULL) {
+        return false;
+    }
+    input->handler = handler;
+    input->object = object;
+    input->last_change = DigitalInputGetState(input);
+    GpioSetEventHandler(gpio, DigitalInputEdge, input, true, true);
+
+    return true;
+}
+
 /* === End of documentation ==================================================================== */
 
-/** @} End of module definition for doxygen */
\ No newline at end of file
+/** @} End of module definition for doxygen */
@@ -46,376 +46,489 @@
 #include "chip.h"
 #include <stdbool.h>
 #include "digital.h"
+#include "modos.h"
+#include "diagnostico.h"
+#include "protocolo.h"
+#include "tiempo.h"
 #include "timers.h"
+#include "queue.h"
 #include "task.h"
-#include "semphr.h"
-#include "event_groups.h"
 
 /* === Macros definitions ====================================================================== */
 //#define RES_RELOJ         6    // Cuantos digitos tiene el reloj
 #define RES_DISPLAY_RELOJ    4    // Cuantos digitos del reloj se mostrarán
 #define INT_PER_SECOND       1000 // interrupciones por segundo del systick
-#define DELAY_SET_TIME_ALARM 3 // segundos de delay para que se active el boton set_time o set_alarm
-#define MAX_IDLE_TIME        5 // cantidad de segundos antes de cancelar por inactividad
-#define EVENT_F1_ON          (1 << 0)
-#define EVENT_F2_ON          (1 << 1)
-#define EVENT_F3_ON          (1 << 2)
-#define EVENT_F4_ON          (1 << 3)
-#define EVENT_ACCEPT_ON      (1 << 4)
-#define EVENT_CANCEL_ON      (1 << 5)
-#define EVENT_F1_OFF         (1 << 6)
-#define EVENT_F2_OFF         (1 << 7)
-#define EVENT_F3_OFF         (1 << 8)
-#define EVENT_F4_OFF         (1 << 9)
-#define EVENT_ACCEPT_OFF     (1 << 10)
-#define EVENT_CANCEL_OFF     (1 << 11)
-#define BIT_0                (1 << 0)
-#define BIT_1                (1 << 1)
+// Comando que solo despierta a ClockTask en el cambio de segundo, sin evento para los modos
+#define COMMAND_SECOND       EVENTOS_CANTIDAD
+// Comando para ejecutar el pedido que llego completo por el protocolo de la consola
+#define COMMAND_REMOTE       (EVENTOS_CANTIDAD + 1)
+#define COMMAND_QUEUE_LENGTH 8
+// Valor de la notificacion de ClockTask a DisplayTask
+#define DISPLAY_SECOND       (1 << 0) // cambio de segundo: se escribe la hora
+#define DISPLAY_HALF_SECOND  (1 << 1) // medio segundo: solo parpadea el punto
+// Valor de la notificacion a DiagnosticTask
+#define CONSOLE_REPORT       (1 << 0) // se pidio el reporte de diagnostico
+#define CONSOLE_RESPONSE     (1 << 1) // hay una respuesta del protocolo para enviar
+// Con la pantalla apagada ClockTask duerme hasta la proxima alarma, pero como mucho este tiempo
+#define SLEEP_DISPLAY_OFF_S  60
+
+// Pilas de cada tarea, en palabras. Se pueden ajustar desde el makefile segun las marcas de agua
+// que se midan en la placa.
+#if !defined(STACK_REFRESH_TASK)
+    #define STACK_REFRESH_TASK 512
+#endif
+#if !defined(STACK_CLOCK_TASK)
+    #define STACK_CLOCK_TASK 384
+#endif
+#if !defined(STACK_DISPLAY_TASK)
+    #define STACK_DISPLAY_TASK 512
+#endif
+#if !defined(STACK_DIAGNOSTIC_TASK)
+    #define STACK_DIAGNOSTIC_TASK 256
+#endif
+#if !defined(STACK_CONSOLE_TASK)
+    #define STACK_CONSOLE_TASK 256
+#endif
+
+// Las dos variantes de CREAR_TAREA devuelven el manejador de la tarea creada, o NULL.
+// Con STATIC_ALLOCATION cada tarea y la cola de comandos tienen su memoria reservada en tiempo de
+// compilacion y no se usa el heap
+#if defined(STATIC_ALLOCATION)
+    #define CREAR_TAREA(funcion, nombre, pila, prioridad)                                          \
+        ({                                                                                         \
+            static StackType_t funcion##_pila[pila];                                               \
+            static StaticTask_t funcion##_tcb;                                                     \
+            xTaskCreateStatic(funcion, nombre, pila, NULL, prioridad, funcion##_pila,              \
+                              &funcion##_tcb);                                                     \
+        })
+    #define CREAR_COLA(cola, largo, tipo)                                                          \
+        do {                                                                                       \
+            static StaticQueue_t cola##_memoria;                                                   \
+            static uint8_t cola##_elementos[(largo) * sizeof(tipo)];                               \
+            cola = xQueueCreateStatic(largo, sizeof(tipo), cola##_elementos, &cola##_memoria);     \
+        } while (0)
+#else
+    #define CREAR_TAREA(funcion, nombre, pila, prioridad)                                          \
+        ({                                                                                         \
+            TaskHandle_t tarea = NULL;                                                             \
+            xTaskCreate(funcion, nombre, pila, NULL, prioridad, &tarea);                           \
+            tarea;                                                                                 \
+        })
+    #define CREAR_COLA(cola, largo, tipo) cola = xQueueCreate(largo, sizeof(tipo))
+#endif
 
 /* === Private data type declarations ========================================================== */
-typedef void (*function_t)(void);
-typedef enum {
-    SIN_CONFIGURAR,
-    MOSTRANDO_HORA,
-    AJUSTANDO_MINUTOS_ACTUAL,
-    AJUSTANDO_HORAS_ACTUAL,
-    AJUSTANDO_MINUTOS_ALARMA,
-    AJUSTANDO_HORAS_ALARMA,
-} modo_t;
-
-typedef struct key_s {
-    uint16_t key_bit;
-    // uint8_t mode;
-    function_t funcion;
-} * key_t;
+
+//! Pedido para la tarea duena del reloj y de la maquina de estados
+typedef struct command_s {
+    uint8_t event;  // evento_t, COMMAND_SECOND o COMMAND_REMOTE
+    uint32_t sent;  // DiagnosticoContador() al encolarlo, para medir la latencia
+} command_t;
 
 /* === Private variable declarations ===========================================================*/
 static board_t board;
 static reloj_t reloj;
-static uint8_t temp_input[4] = {0, 0, 0, 0}; // 4 porque nunca se configura la hora por minutos
-static const uint8_t limite_min[] = {5, 9};
-static const uint8_t limite_hs[] = {2, 3};
-static bool alarma_sonando = false;
-static bool flag_set_time_alarm = false; // para que el systick sepa cuando se presiono el boton
-static uint8_t cnt_set_time_alarm = DELAY_SET_TIME_ALARM; // contador para el delay del boton
-static bool flag_idle = false; // bandera para el "cancel" por inactividad
-static uint8_t cnt_idle = MAX_IDLE_TIME;
+static modos_t modos;
+static TaskHandle_t diagnostic_task;
+static TaskHandle_t refresh_task;
+static volatile uint32_t refresh_missed; // periodos de barrido que RefreshTask no llego a cumplir
+static reloj_fuente_t fuente;
+static QueueHandle_t command_queue;
+static TaskHandle_t display_task;
+static volatile uint32_t display_signal_sent;
+static volatile uint32_t display_latency; // maxima demora de DisplayTask en atender un aviso, en us
+static volatile uint32_t commands_processed;
+static volatile uint32_t commands_lost;   // comandos descartados con la cola llena
+static volatile uint32_t command_latency; // maxima espera en la cola, en microsegundos
+static protocolo_t protocolo;
+static volatile bool display_on; // lo publica ClockTask, asi RefreshTask no lee los modos
+static bool alarm_pending; // el reloj cambio el estado de la alarma y modos todavia no lo sabe
+static bool alarm_ringing;
 
 /* === Private function declarations ===========================================================
  */
 
 void ActivarAlarma(reloj_t reloj, bool act_desact);
-void CambiarModo(modo_t modo);
-void IncrementarBCD(uint8_t numero[2], const uint8_t limite[2]);
-// limite indica donde se pasa despues de restar 1 a 00
-void DecrementarBCD(uint8_t numero[2], const uint8_t limite[2]);
-
-void AcceptKeyLogic(void);
-void CancelKeyLogic(void);
-void F1KeyLogic(void);
-void F2KeyLogic(void);
-void F3KeyLogic(void);
-void F4KeyLogic(void);
 
 /* === Public variable definitions ============================================================= */
-modo_t modo;
-EventGroupHandle_t key_group_handle;
-EventGroupHandle_t clock_group_handle; // para controlar la verificacion de un nuevo segundo
-SemaphoreHandle_t mode_mutex;
 /* === Private variable definitions ============================================================ */
 
 /* === Private function implementation ========================================================= */
 
+// Encola un comando sin esperar. Si la cola esta llena se descarta y se cuenta.
+static void SendCommand(uint8_t event) {
+    command_t command = {.event = event, .sent = DiagnosticoContador()};
+
+    if (xQueueSend(command_queue, &command, 0) != pdTRUE) {
+        commands_lost++;
+    }
+}
+
 void ActivarAlarma(reloj_t reloj, bool act_desact) {
     if (act_desact) {
         DigitalOutputActivate(board->buzzer);
-        alarma_sonando = true;
     } else {
         DigitalOutputDeactivate(board->buzzer);
-        alarma_sonando = false;
     }
+    // Se llama desde ClockTask, dentro de ClockUpdate o de ModosProcesar, que no admite que se
+    // lo vuelva a llamar. El evento se procesa en ProcessAlarm, sin pasar por la cola.
+    alarm_ringing = act_desact;
+    alarm_pending = true;
 }
 
-void CambiarModo(modo_t valor) {
-    xSemaphoreTake(mode_mutex, portMAX_DELAY);
-    modo = valor;
-    xSemaphoreGive(mode_mutex);
-
-    switch (modo) {
-    case SIN_CONFIGURAR:
-        DisplayFlashDigits(board->display, 0, 3, 250);
-        break;
-    case MOSTRANDO_HORA:
-        DisplayFlashDigits(board->display, 0, 3, 0); // digitos sin parpadear
-        // SetClockTime(reloj, (uint8_t[]){1, 2, 3, 4}, RES_DISPLAY_RELOJ);
-        break;
-    case AJUSTANDO_MINUTOS_ACTUAL:
-        DisplayFlashDigits(board->display, 2, 3, 250);
-        break;
-    case AJUSTANDO_HORAS_ACTUAL:
-        DisplayFlashDigits(board->display, 0, 1, 250);
-        break;
-    case AJUSTANDO_MINUTOS_ALARMA:
-        DisplayFlashDigits(board->display, 2, 3, 250);
-        break;
-    case AJUSTANDO_HORAS_ALARMA:
-        DisplayFlashDigits(board->display, 0, 1, 250);
-        break;
-    default:
-        break;
+// Las teclas avisan por interrupcion, ya sin rebotes, desde la tarea de timers. Solo interesa
+// cuando se presionan, y estan en el mismo orden que sus eventos: F1, F2, F3, F4, ACCEPT, CANCEL.
+static void KeyEvent(digital_input_t input, bool active, void * object) {
+    const digital_input_t keys[] = {
+        board->set_time, board->set_alarm, board->decrement,
+        board->increment, board->accept,   board->cancel,
+    };
+
+    for (size_t i = 0; active && i < sizeof(keys) / sizeof(keys[0]); i++) {
+        if (keys[i] == input) {
+            SendCommand(EVENTO_F1 + i);
+            break;
+        }
     }
 }
 
-void IncrementarBCD(uint8_t numero[2], const uint8_t limite[2]) {
-
-    // uint8_t temp_limite_1 = limite[1];
+#if !defined(DISPLAY_SCAN_DMA)
+// Barre la pantalla con un periodo absoluto, asi el tiempo de cada barrido no se acumula. Si la
+// tarea no pudo correr a tiempo se cuentan los periodos perdidos y se retoma desde ese momento,
+// sin barridos de recuperacion. Con la pantalla apagada espera a que ClockTask la despierte.
+static void RefreshTask(void * object) {
+    const TickType_t periodo = pdMS_TO_TICKS(1);
+    TickType_t ultimo = xTaskGetTickCount();
+    TickType_t ahora;
 
-    numero[1]++;
+    while (true) {
+        if (xTaskDelayUntil(&ultimo, periodo) == pdFALSE) {
+            ahora = xTaskGetTickCount();
+            refresh_missed += (ahora - ultimo) / periodo;
+            ultimo = ahora;
+        }
+        BoardDisplayRefresh(board);
 
-    // Corroboro antes si se llego al limite para que el ahora segundo if no me rompa la condicion
-    // de limite
-    if ((numero[0] == limite[0]) && (numero[1] > limite[1])) {
-        numero[0] = 0;
-        numero[1] = 0;
+        while (!display_on) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            ultimo = xTaskGetTickCount();
+        }
     }
+}
+#endif
 
-    if (numero[1] > 9) {
-
-        numero[1] = 0;
-        numero[0]++;
-    }
+static uint32_t ReadTicks(void) {
+    return xTaskGetTickCount();
 }
 
-void DecrementarBCD(uint8_t numero[2], const uint8_t limite[2]) {
-    numero[1]--;
+//! Fuente de tiempo por defecto: el contador de ticks del sistema operativo
+static const struct reloj_fuente_s FUENTE_TICKS = {
+    .Leer = ReadTicks,
+    .frecuencia = configTICK_RATE_HZ,
+};
 
-    if ((numero[0] == 0) && ((int8_t)numero[1] < 0)) {
-        numero[0] = limite[0];
-        numero[1] = limite[1];
-    }
-    if ((int8_t)numero[1] < 0) {
+// Ticks que faltan para que la fuente del reloj llegue a 'hasta'
+static TickType_t SourceTicks(uint32_t hasta) {
+    int32_t cuentas = (int32_t)(hasta - fuente->Leer());
 
-        numero[1] = 9;
-        numero[0]--;
+    if (cuentas <= 0) {
+        return 0;
     }
+    return (uint64_t)cuentas * configTICK_RATE_HZ / fuente->frecuencia;
 }
 
-void AcceptKeyLogic(void) {
-
-    // ACEPTAR
-
-    if (modo == AJUSTANDO_MINUTOS_ACTUAL) {
-        cnt_idle = MAX_IDLE_TIME;
-        CambiarModo(AJUSTANDO_HORAS_ACTUAL);
-    } else if (modo == AJUSTANDO_MINUTOS_ALARMA) {
-        cnt_idle = MAX_IDLE_TIME;
-        CambiarModo(AJUSTANDO_HORAS_ALARMA);
-    } else if (modo == AJUSTANDO_HORAS_ACTUAL) {
-        CambiarModo(MOSTRANDO_HORA);
-        SetClockTime(reloj, temp_input, sizeof(temp_input));
-    } else if (modo == AJUSTANDO_HORAS_ALARMA) {
-        DisplayClearDot(board->display, DOT_0 | DOT_1 | DOT_2);
-        SetAlarmTime(reloj, temp_input);
-        CambiarModo(MOSTRANDO_HORA);
-    } else if (modo == MOSTRANDO_HORA) {
-        if (!GetAlarmTime(reloj, temp_input)) {
-            ToggleHabAlarma(reloj);
-            DisplaySetDot(board->display, DOT_3);
-        } else if (alarma_sonando) {
-            PosponerAlarma(reloj, 5);
-        }
+// Aviso de cambio de segundo de las fuentes de 1 Hz, desde su interrupcion
+static void SecondEvent(void) {
+    BaseType_t higher_priority_woken = pdFALSE;
+    command_t command = {.event = COMMAND_SECOND, .sent = DiagnosticoContador()};
+
+    if (xQueueSendFromISR(command_queue, &command, &higher_priority_woken) != pdTRUE) {
+        commands_lost++;
     }
+    portYIELD_FROM_ISR(higher_priority_woken);
 }
 
-void CancelKeyLogic(void) {
-    if (modo == AJUSTANDO_MINUTOS_ACTUAL || modo == AJUSTANDO_MINUTOS_ALARMA) {
-        if (GetClockTime(reloj, temp_input, sizeof(temp_input))) {
-            CambiarModo(MOSTRANDO_HORA);
-            DisplayClearDot(board->display, DOT_MASK);
-        } else {
-            CambiarModo(SIN_CONFIGURAR);
-        }
-    } else if (modo == AJUSTANDO_HORAS_ACTUAL) {
-        cnt_idle = MAX_IDLE_TIME;
-        CambiarModo(AJUSTANDO_MINUTOS_ACTUAL);
-    } else if (modo == AJUSTANDO_HORAS_ALARMA) {
-        cnt_idle = MAX_IDLE_TIME;
-        CambiarModo(AJUSTANDO_MINUTOS_ALARMA);
-    } else if (modo == MOSTRANDO_HORA) {
-        if (GetAlarmTime(reloj, temp_input) && !alarma_sonando) {
-            ToggleHabAlarma(reloj);
-            DisplayClearDot(board->display, DOT_3);
-        } else if (alarma_sonando) {
-            CancelarAlarma(reloj);
-        }
+// Ejecuta un comando y registra cuanto espero en la cola
+static void ProcessCommand(const command_t * command) {
+    uint32_t latency = DiagnosticoContador() - command->sent;
+
+    if (latency > command_latency) {
+        command_latency = latency;
     }
-}
-// SET-TIME
-void F4KeyLogic(void) {
-
-    flag_set_time_alarm ^= 1;
-    // if (cnt_set_time_alarm == 0) { // if (cnt_set_time_alarm == 0) cambio a 3 para test
-
-    flag_idle = true;
-    cnt_idle = MAX_IDLE_TIME;
-    CambiarModo(AJUSTANDO_MINUTOS_ACTUAL);
-    GetClockTime(reloj, temp_input, sizeof(temp_input));
-    DisplayClearDot(board->display, DOT_1);
-    DisplayWriteBCD(board->display, temp_input, sizeof(temp_input));
-    //}
-}
-// SET-ALARM
-void F3KeyLogic(void) {
-    flag_set_time_alarm ^= 1;
-    // if (cnt_set_time_alarm == 0 && modo != SIN_CONFIGURAR) {
-    flag_idle = true;
-    cnt_idle = MAX_IDLE_TIME;
-    CambiarModo(AJUSTANDO_MINUTOS_ALARMA);
-    GetAlarmTime(reloj, temp_input);
-    DisplaySetDot(board->display, DOT_MASK);
-    DisplayWriteBCD(board->display, temp_input, sizeof(temp_input));
-    //}
-}
-// DECREMENT
-void F2KeyLogic(void) {
-    cnt_idle = MAX_IDLE_TIME;
-    if (modo == AJUSTANDO_MINUTOS_ACTUAL || modo == AJUSTANDO_MINUTOS_ALARMA) {
-        DecrementarBCD(&temp_input[2], limite_min);
-    } else if (modo == AJUSTANDO_HORAS_ACTUAL || modo == AJUSTANDO_HORAS_ALARMA) {
-        DecrementarBCD(temp_input, limite_hs);
+    commands_processed++;
+    if (command->event == COMMAND_REMOTE) {
+        // La respuesta la envia DiagnosticTask, que es la que puede esperar a la consola
+        if (ProtocoloEjecutar(protocolo)) {
+            xTaskNotify(diagnostic_task, CONSOLE_RESPONSE, eSetBits);
+        }
+    } else {
+        ModosProcesar(modos, command->event); // COMMAND_SECOND no es un evento, lo ignora
     }
-    DisplayWriteBCD(board->display, temp_input, sizeof(temp_input));
 }
-// INCREMENT
-void F1KeyLogic(void) {
-    cnt_idle = MAX_IDLE_TIME;
-    if (modo == AJUSTANDO_MINUTOS_ACTUAL || modo == AJUSTANDO_MINUTOS_ALARMA) {
-        // le paso el puntero a los dos digitos menos significativos
-        IncrementarBCD(&temp_input[2], limite_min);
-    } else if (modo == AJUSTANDO_HORAS_ACTUAL || modo == AJUSTANDO_HORAS_ALARMA) {
-        IncrementarBCD(temp_input, limite_hs);
+
+// Entrega a la maquina de estados el ultimo cambio de la alarma
+static void ProcessAlarm(void) {
+    while (alarm_pending) {
+        alarm_pending = false;
+        ModosProcesar(modos, alarm_ringing ? EVENTO_ALARMA_SONANDO : EVENTO_ALARMA_CALLADA);
     }
-    DisplayWriteBCD(board->display, temp_input, sizeof(temp_input));
 }
 
-static void KeyTask(void * object) {
-    // board_t board = object;
-    uint16_t events, current_state, last_state, changes;
+// Publica si la pantalla esta encendida y al encenderla despierta a RefreshTask para que vuelva a
+// barrer. Devuelve true si se acaba de encender.
+static bool PublishDisplay(void) {
+    bool on = (ModosActual(modos) != PANTALLA_APAGADA);
+    bool turned_on = on && !display_on;
 
-    while (1) {
-        vTaskDelay(pdMS_TO_TICKS(50));
+    display_on = on;
+    if (turned_on && refresh_task) {
+        xTaskNotifyGive(refresh_task);
+    }
+    return turned_on;
+}
 
-        if (DigitalInputGetState(board->accept)) {
-            current_state |= EVENT_ACCEPT_ON;
+// Unica duena del reloj y de la maquina de estados: todos los cambios le llegan como comandos por
+// una cola, asi no hacen falta mutex. Los comandos que llegan juntos se atienden en una sola vuelta.
+// El reloj lee su fuente de tiempo solo cuando se lo consulta, por lo que la tarea solo se despierta
+// en cada medio segundo en lugar de hacerlo en cada tick. Con las fuentes de 1 Hz el cambio de
+// segundo lo avisa la interrupcion de la fuente con un comando y el medio segundo se mide con ticks.
+// Con la pantalla apagada duerme hasta la proxima alarma o hasta que llegue un comando.
+static void ClockTask(void * object) {
+    command_t command;
+    TickType_t wake_up = xTaskGetTickCount();
+    TickType_t wait;
+    uint32_t proximo;
+    bool medio_segundo = false;
+    bool avisando = false;
+    bool second, remote, off;
+    int fase;
+
+    PublishDisplay();
+    while (true) {
+        wait = wake_up - xTaskGetTickCount();
+        if ((int32_t)wait < 0) {
+            wait = 0;
         }
-        if (DigitalInputGetState(board->cancel)) {
-            current_state |= EVENT_CANCEL_ON;
+        second = false;
+        remote = false;
+        if (xQueueReceive(command_queue, &command, wait) == pdTRUE) {
+            off = (ModosActual(modos) == PANTALLA_APAGADA);
+            do {
+                second |= (command.event == COMMAND_SECOND);
+                remote |= (command.event == COMMAND_REMOTE);
+                ProcessCommand(&command);
+                ProcessAlarm(); // posponer o cancelar la alarma tambien la calla
+            } while (xQueueReceive(command_queue, &command, 0) == pdTRUE);
+
+            if (PublishDisplay()) {
+                // Al encender la pantalla se muestra la hora enseguida
+                medio_segundo = false;
+            } else if (!second && !(remote && off) && (off == !display_on)) {
+                // sigue esperando el mismo momento, salvo que con la pantalla apagada un pedido
+                // remoto haya cambiado la hora o las alarmas
+                continue;
+            }
+        } else if (avisando) {
+            // Sin aviso de la fuente: medio segundo despues del cambio, o el aviso se perdio
+            medio_segundo = !medio_segundo;
         }
-        if (DigitalInputGetState(board->set_time)) {
-            current_state |= EVENT_F1_ON;
+        if (second) {
+            medio_segundo = false;
         }
-        if (DigitalInputGetState(board->set_alarm)) {
-            current_state |= EVENT_F2_ON;
+
+        fase = ClockUpdate(reloj);
+        ProcessAlarm();
+        if (PublishDisplay()) {
+            // la alarma que empieza a sonar enciende la pantalla
+            medio_segundo = false;
         }
-        if (DigitalInputGetState(board->decrement)) {
-            current_state |= EVENT_F3_ON;
+        if (ModosActual(modos) <= MOSTRANDO_HORA) {
+            display_signal_sent = DiagnosticoContador();
+            xTaskNotify(display_task, medio_segundo ? DISPLAY_HALF_SECOND : DISPLAY_SECOND,
+                        eSetBits);
         }
-        if (DigitalInputGetState(board->increment)) {
-            current_state |= EVENT_F4_ON;
+
+        if (fuente->AvisarSegundo && (avisando != (ModosActual(modos) != PANTALLA_APAGADA))) {
+            avisando = !avisando;
+            fuente->AvisarSegundo(avisando ? SecondEvent : NULL);
         }
 
-        changes = current_state ^ last_state;
-        last_state = current_state;
-        events = ((changes & !current_state) << 6) | (changes & current_state);
-        xEventGroupSetBits(key_group_handle, events);
-        current_state = 0;
+        if (ModosActual(modos) == PANTALLA_APAGADA) {
+            medio_segundo = false;
+            proximo = ClockNextAlarmTick(reloj, SLEEP_DISPLAY_OFF_S);
+            wake_up = xTaskGetTickCount() + SourceTicks(proximo);
+        } else if (avisando) {
+            wake_up = xTaskGetTickCount() + pdMS_TO_TICKS(medio_segundo ? 2000 : 500);
+        } else {
+            proximo = ClockNextEventTick(reloj);
+            medio_segundo = (fase < fuente->frecuencia / 2);
+            if (medio_segundo) {
+                proximo -= fuente->frecuencia / 2;
+            }
+            wake_up = xTaskGetTickCount() + SourceTicks(proximo);
+        }
     }
 }
 
-static void ModeTask(void * object) {
-    key_t options = object;
-    while (1) {
-        xEventGroupWaitBits(key_group_handle, options->key_bit, TRUE, FALSE, portMAX_DELAY);
+// Recibe los avisos de ClockTask como notificacion directa, mas barata que un grupo de eventos.
+// Si llegan los dos avisos juntos alcanza con el del segundo.
+static void DisplayTask(void * object) {
+    uint8_t hora[RES_DISPLAY_RELOJ];
+    uint32_t events, latency;
 
-        options->funcion();
+    while (true) {
+        xTaskNotifyWait(0, UINT32_MAX, &events, portMAX_DELAY);
+        latency = DiagnosticoContador() - display_signal_sent;
+        if (latency > display_latency) {
+            display_latency = latency;
+        }
+        if ((events & DISPLAY_SECOND) != 0) {
+            (void)GetClockTime(reloj, hora, RES_DISPLAY_RELOJ);
+            DisplayWriteBCD(board->display, hora, sizeof(hora));
+            DisplayToggleDot(board->display, 1);
+        } else if ((events & DISPLAY_HALF_SECOND) != 0) {
+            DisplayToggleDot(board->display, 1);
+        }
     }
 }
 
-static void RefreshTask(void * object) {
-    int tick;
-    while (true) {
-        vTaskDelay(pdMS_TO_TICKS(1));
-        tick = RelojNuevoTick(reloj);
-        if (modo <= MOSTRANDO_HORA) {
-            if (tick == 0) {
-                xEventGroupSetBits(clock_group_handle, BIT_0);
-            } else if (tick == TICKS_PER_SECOND / 2) {
-                xEventGroupSetBits(clock_group_handle, BIT_1);
+// Recibe los caracteres de la consola. Las tramas del protocolo se decodifican aca y el pedido
+// completo lo ejecuta ClockTask, que es la duena del reloj. El pedido de reporte lo atiende
+// DiagnosticTask, porque armar y enviar el texto no se puede hacer en la interrupcion. Cuando se
+// vacia la salida o termina el bloque enviado se despierta a la tarea que lo esta enviando.
+static void ConsoleEvent(hal_sci_t sci, sci_status_t status, void * object) {
+    BaseType_t higher_priority_woken = pdFALSE;
+    command_t command = {.event = COMMAND_REMOTE};
+    protocolo_recepcion_t recepcion;
+    uint8_t dato;
+
+    if ((status->tx_low_water || status->block_sent) && DiagnosticoConsolaLibre()) {
+        higher_priority_woken = pdTRUE;
+    }
+    while (status->data_ready && SciReceiveData(sci, &dato, 1)) {
+        recepcion = ProtocoloRecibir(protocolo, dato);
+        if (recepcion == PROTOCOLO_PEDIDO) {
+            command.sent = DiagnosticoContador();
+            if (xQueueSendFromISR(command_queue, &command, &higher_priority_woken) != pdTRUE) {
+                // Sin respuesta, quien envio el pedido lo repite
+                commands_lost++;
+                ProtocoloLiberar(protocolo);
             }
+        } else if ((recepcion == PROTOCOLO_TEXTO) && (dato == DIAGNOSTICO_COMANDO)) {
+            xTaskNotifyFromISR(diagnostic_task, CONSOLE_REPORT, eSetBits, &higher_priority_woken);
         }
+        SciReadStatus(sci, status);
+    }
+    portYIELD_FROM_ISR(higher_priority_woken);
+}
+
+#if defined(POSIX)
+// En posix los eventos del puerto llegan por hilos que no son del kernel y no pueden usar su API.
+// Esta tarea hace de interrupcion de la consola: con la prioridad mas alta consulta el puerto en
+// cada tick. Con la salida vacia ya termino el bloque y hay lugar bajo la marca baja.
+static void ConsoleTask(void * object) {
+    struct sci_status_s status;
 
-        DisplayRefresh(board->display);
+    while (true) {
+        vTaskDelay(1);
+        SciReadStatus(board->console, &status);
+        status.tx_low_water = status.fifo_empty;
+        status.block_sent = status.fifo_empty;
+        ConsoleEvent(board->console, &status, NULL);
     }
 }
+#endif
 
-static void DisplayTask(void * object) {
-    uint8_t hora[RES_DISPLAY_RELOJ];
-    EventBits_t ux_bits;
+// Unica tarea que escribe en la consola: las respuestas del protocolo y los reportes
+static void DiagnosticTask(void * object) {
+    const uint8_t * response;
+    uint16_t length;
+    uint32_t events;
 
     while (true) {
-        ux_bits =
-            xEventGroupWaitBits(clock_group_handle, BIT_0 | BIT_1, TRUE, FALSE, portMAX_DELAY);
-        if ((ux_bits & BIT_0) != 0) {
-            (void)GetClockTime(reloj, hora, RES_DISPLAY_RELOJ);
-            DisplayWriteBCD(board->display, hora, sizeof(hora));
-            DisplayToggleDot(board->display, 1);
-        } else if ((ux_bits & BIT_1) != 0) {
-            DisplayToggleDot(board->display, 1);
+        xTaskNotifyWait(0, UINT32_MAX, &events, portMAX_DELAY);
+        if ((events & CONSOLE_RESPONSE) != 0) {
+            length = ProtocoloRespuesta(protocolo, &response);
+            DiagnosticoEnviar(board->console, response, length);
+            ProtocoloLiberar(protocolo);
+        }
+        if ((events & CONSOLE_REPORT) != 0) {
+            DiagnosticoReportar(board->console);
         }
     }
 }
 
 /* === Public function implementation ========================================================= */
+
+#if defined(STATIC_ALLOCATION)
+// Memoria de las tareas que crea el kernel, requerida con configSUPPORT_STATIC_ALLOCATION
+void vApplicationGetIdleTaskMemory(StaticTask_t ** tcb, StackType_t ** pila, uint32_t * tamanio) {
+    static StaticTask_t idle_tcb;
+    static StackType_t idle_pila[configMINIMAL_STACK_SIZE];
+
+    *tcb = &idle_tcb;
+    *pila = idle_pila;
+    *tamanio = configMINIMAL_STACK_SIZE;
+}
+
+void vApplicationGetTimerTaskMemory(StaticTask_t ** tcb, StackType_t ** pila, uint32_t * tamanio) {
+    static StaticTask_t timer_tcb;
+    static StackType_t timer_pila[configTIMER_TASK_STACK_DEPTH];
+
+    *tcb = &timer_tcb;
+    *pila = timer_pila;
+    *tamanio = configTIMER_TASK_STACK_DEPTH;
+}
+#endif
+
 /*Falta completar con las pulsaciones largas y la alarma*/
 
 int main(void) {
     board = BoardCreate();
-    reloj = ClockCreate(TICKS_PER_SECOND, ActivarAlarma);
-    mode_mutex = xSemaphoreCreateMutex();
-    key_group_handle = xEventGroupCreate();
-    clock_group_handle = xEventGroupCreate();
-    modo = SIN_CONFIGURAR;
+#if defined(CLOCK_SOURCE_RTC)
+    fuente = FUENTE_RTC;
+#else
+    fuente = &FUENTE_TICKS;
+#endif
+    reloj = ClockCreateFromSource(fuente, ActivarAlarma);
+    CREAR_COLA(command_queue, COMMAND_QUEUE_LENGTH, command_t);
+    modos = ModosCrear(reloj, board->display);
     DisplayToggleDot(board->display, 1);
-    DisplayFlashDigits(board->display, 0, 3, 250);
-
-    static struct key_s key[6];
-    key[0].key_bit = EVENT_F1_ON;
-    key[0].funcion = F1KeyLogic;
-    key[1].key_bit = EVENT_F2_ON;
-    key[1].funcion = F2KeyLogic;
-    key[2].key_bit = EVENT_F3_ON;
-    key[2].funcion = F3KeyLogic;
-    key[3].key_bit = EVENT_F4_ON;
-    key[3].funcion = F4KeyLogic;
-    key[4].key_bit = EVENT_ACCEPT_ON;
-    key[4].funcion = AcceptKeyLogic;
-    key[5].key_bit = EVENT_CANCEL_ON;
-    key[5].funcion = CancelKeyLogic;
-
-    if (key_group_handle == NULL) {
+
+    if (command_queue == NULL) {
         while (1) {
         };
     }
 
-    xTaskCreate(KeyTask, "KeysReading", 256, NULL, tskIDLE_PRIORITY + 2, NULL);
-    xTaskCreate(ModeTask, "ChangeModeWhenF1", 256, &key[0], tskIDLE_PRIORITY + 1, NULL);
-    xTaskCreate(ModeTask, "ChangeModeWhenF2", 256, &key[1], tskIDLE_PRIORITY + 1, NULL);
-    xTaskCreate(ModeTask, "ChangeModeWhenF3", 256, &key[2], tskIDLE_PRIORITY + 1, NULL);
-    xTaskCreate(ModeTask, "ChangeModeWhenF4", 256, &key[3], tskIDLE_PRIORITY + 1, NULL);
-    xTaskCreate(ModeTask, "ChangeModeWhenAccept", 256, &key[4], tskIDLE_PRIORITY + 1, NULL);
-    xTaskCreate(ModeTask, "ChangeModeWhenCancel", 256, &key[5], tskIDLE_PRIORITY + 1, NULL);
-    xTaskCreate(RefreshTask, "RefreshDisplay", 512, NULL, tskIDLE_PRIORITY + 3, NULL);
-    xTaskCreate(DisplayTask, "WriteDisplay", 512, NULL, tskIDLE_PRIORITY + 3, NULL);
+    BoardKeysSetEventHandler(KeyEvent, NULL);
+#if !defined(DISPLAY_SCAN_DMA)
+    // Con DISPLAY_SCAN_DMA la pantalla la barren un timer y el GPDMA, sin esta tarea
+    refresh_task =
+        CREAR_TAREA(RefreshTask, "RefreshDisplay", STACK_REFRESH_TASK, tskIDLE_PRIORITY + 3);
+#endif
+    CREAR_TAREA(ClockTask, "ClockUpdate", STACK_CLOCK_TASK, tskIDLE_PRIORITY + 3);
+    display_task =
+        CREAR_TAREA(DisplayTask, "WriteDisplay", STACK_DISPLAY_TASK, tskIDLE_PRIORITY + 3);
+    if (board->console) {
+        protocolo = ProtocoloCrear(reloj, modos);
+        diagnostic_task = CREAR_TAREA(DiagnosticTask, "Diagnostic", STACK_DIAGNOSTIC_TASK,
+                                      tskIDLE_PRIORITY + 1);
+#if !defined(DISPLAY_SCAN_DMA)
+        DiagnosticoAgregarContador("Barridos perdidos", &refresh_missed);
+        DiagnosticoAgregarContador("Ciclos barrido", &board->refresh_cycles.last);
+        DiagnosticoAgregarContador("Ciclos barrido max", &board->refresh_cycles.max);
+#endif
+        DiagnosticoAgregarContador("Comandos", &commands_processed);
+        DiagnosticoAgregarContador("Comandos perdidos", &commands_lost);
+        DiagnosticoAgregarContador("Latencia max (us)", &command_latency);
+        DiagnosticoAgregarContador("Latencia pantalla (us)", &display_latency);
+        DiagnosticoAgregarContador("Tramas descartadas", ProtocoloDescartadas(protocolo));
+#if defined(POSIX)
+        CREAR_TAREA(ConsoleTask, "Console", STACK_CONSOLE_TASK, configMAX_PRIORITIES - 1);
+#else
+        SciSetEventHandler(board->console, ConsoleEvent, NULL);
+#endif
+    }
 
     vTaskStartScheduler();
 
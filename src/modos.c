@@ -0,0 +1,394 @@
+/************************************************************************************************
+Copyright (c) 2023, Emiliano Arnedo <emiarnedo@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** \brief Maquina de estados de la interfaz del reloj
+ **
+ ** Cada evento se resuelve con un solo acceso a la tabla de transiciones: una accion opcional y,
+ ** si la transicion cambia de modo, la accion de entrada del modo nuevo (el parpadeo de la
+ ** pantalla), que tambien sale de una tabla.
+ **
+ ** \addtogroup modos Modos
+ ** \brief Maquina de estados de la interfaz
+ ** @{ */
+
+/* === Headers files inclusions =============================================================== */
+
+#include "modos.h"
+#include <stddef.h>
+
+/* === Macros definitions ====================================================================== */
+
+#define DIGITOS_ENTRADA 4 // hh:mm, nunca se ajustan los segundos
+#define MINUTOS_POSPONER 5
+
+// Transicion a otro modo, o al mismo volviendo a ejecutar su accion de entrada
+#define IR_A(destino, funcion)                                                                     \
+    { .accion = funcion, .siguiente = destino, .cambia = true }
+// Transicion interna: solo se ejecuta la accion. Las entradas no inicializadas de la tabla son
+// transiciones internas sin accion, es decir, eventos ignorados.
+#define QUEDARSE(funcion)                                                                          \
+    { .accion = funcion }
+
+// Las teclas de ajuste se atienden igual en todos los modos
+#define AJUSTES                                                                                    \
+    [EVENTO_F3] = IR_A(AJUSTANDO_MINUTOS_ALARMA, EditarAlarma),                                    \
+    [EVENTO_F4] = IR_A(AJUSTANDO_MINUTOS_ACTUAL, EditarHora),                                      \
+    [EVENTO_ALARMA_SONANDO] = QUEDARSE(MarcarSonando),                                             \
+    [EVENTO_ALARMA_CALLADA] = QUEDARSE(MarcarCallada)
+
+// Con la pantalla apagada cualquier tecla solo la enciende, sin hacer nada mas
+#define DESPERTAR                                                                                  \
+    [EVENTO_F1] = IR_A(MOSTRANDO_HORA, Encender), [EVENTO_F2] = IR_A(MOSTRANDO_HORA, Encender),    \
+    [EVENTO_F3] = IR_A(MOSTRANDO_HORA, Encender), [EVENTO_F4] = IR_A(MOSTRANDO_HORA, Encender),    \
+    [EVENTO_ACEPTAR] = IR_A(MOSTRANDO_HORA, Encender),                                             \
+    [EVENTO_CANCELAR] = IR_A(MOSTRANDO_HORA, Encender)
+
+/* === Private data type declarations ========================================================== */
+
+struct modos_s {
+    modo_t modo;
+    reloj_t reloj;
+    display_t display;
+    uint8_t entrada[DIGITOS_ENTRADA]; // valor que se esta ajustando
+    bool sonando;                     // la alarma esta sonando y se puede posponer o cancelar
+};
+
+//! Accion de una transicion. Recibe el modo destino de la tabla y devuelve el modo final.
+typedef modo_t (*accion_t)(modos_t modos, modo_t siguiente);
+
+typedef struct transicion_s {
+    accion_t accion;
+    modo_t siguiente;
+    bool cambia; // false: transicion interna, no se ejecuta la accion de entrada
+} transicion_s;
+
+//! Accion de entrada de cada modo: rango de digitos que parpadean
+typedef struct entrada_s {
+    uint8_t desde;
+    uint8_t hasta;
+    uint16_t factor;
+} entrada_s;
+
+/* === Private variable declarations =========================================================== */
+
+static const uint8_t LIMITE_MINUTOS[] = {5, 9};
+static const uint8_t LIMITE_HORAS[] = {2, 3};
+
+/* === Private function declarations =========================================================== */
+
+static modos_t ModosAllocate(void);
+static void IncrementarBCD(uint8_t numero[2], const uint8_t limite[2]);
+static void DecrementarBCD(uint8_t numero[2], const uint8_t limite[2]);
+static modo_t IncrementarMinutos(modos_t modos, modo_t siguiente);
+static modo_t DecrementarMinutos(modos_t modos, modo_t siguiente);
+static modo_t IncrementarHoras(modos_t modos, modo_t siguiente);
+static modo_t DecrementarHoras(modos_t modos, modo_t siguiente);
+static modo_t EditarHora(modos_t modos, modo_t siguiente);
+static modo_t EditarAlarma(modos_t modos, modo_t siguiente);
+static modo_t GuardarHora(modos_t modos, modo_t siguiente);
+static modo_t GuardarAlarma(modos_t modos, modo_t siguiente);
+static modo_t Descartar(modos_t modos, modo_t siguiente);
+static modo_t ActivarOPosponer(modos_t modos, modo_t siguiente);
+static modo_t DesactivarOCancelar(modos_t modos, modo_t siguiente);
+static modo_t MarcarSonando(modos_t modos, modo_t siguiente);
+static modo_t MarcarCallada(modos_t modos, modo_t siguiente);
+static modo_t Apagar(modos_t modos, modo_t siguiente);
+static modo_t Encender(modos_t modos, modo_t siguiente);
+static modo_t EncenderSonando(modos_t modos, modo_t siguiente);
+static void Entrar(modos_t modos, modo_t modo);
+
+/* === Public variable definitions ============================================================= */
+
+/* === Private variable definitions ============================================================ */
+
+static const transicion_s TRANSICIONES[MODOS_CANTIDAD][EVENTOS_CANTIDAD] = {
+    [SIN_CONFIGURAR] =
+        {
+            AJUSTES,
+            [EVENTO_HORA_CONFIGURADA] = IR_A(MOSTRANDO_HORA, NULL),
+        },
+    [MOSTRANDO_HORA] =
+        {
+            AJUSTES,
+            [EVENTO_F2] = IR_A(PANTALLA_APAGADA, Apagar),
+            [EVENTO_ACEPTAR] = QUEDARSE(ActivarOPosponer),
+            [EVENTO_CANCELAR] = QUEDARSE(DesactivarOCancelar),
+        },
+    [AJUSTANDO_MINUTOS_ACTUAL] =
+        {
+            AJUSTES,
+            [EVENTO_F1] = QUEDARSE(IncrementarMinutos),
+            [EVENTO_F2] = QUEDARSE(DecrementarMinutos),
+            [EVENTO_ACEPTAR] = IR_A(AJUSTANDO_HORAS_ACTUAL, NULL),
+            [EVENTO_CANCELAR] = IR_A(MOSTRANDO_HORA, Descartar),
+        },
+    [AJUSTANDO_HORAS_ACTUAL] =
+        {
+            AJUSTES,
+            [EVENTO_F1] = QUEDARSE(IncrementarHoras),
+            [EVENTO_F2] = QUEDARSE(DecrementarHoras),
+            [EVENTO_ACEPTAR] = IR_A(MOSTRANDO_HORA, GuardarHora),
+            [EVENTO_CANCELAR] = IR_A(AJUSTANDO_MINUTOS_ACTUAL, NULL),
+        },
+    [AJUSTANDO_MINUTOS_ALARMA] =
+        {
+            AJUSTES,
+            [EVENTO_F1] = QUEDARSE(IncrementarMinutos),
+            [EVENTO_F2] = QUEDARSE(DecrementarMinutos),
+            [EVENTO_ACEPTAR] = IR_A(AJUSTANDO_HORAS_ALARMA, NULL),
+            [EVENTO_CANCELAR] = IR_A(MOSTRANDO_HORA, Descartar),
+        },
+    [AJUSTANDO_HORAS_ALARMA] =
+        {
+            AJUSTES,
+            [EVENTO_F1] = QUEDARSE(IncrementarHoras),
+            [EVENTO_F2] = QUEDARSE(DecrementarHoras),
+            [EVENTO_ACEPTAR] = IR_A(MOSTRANDO_HORA, GuardarAlarma),
+            [EVENTO_CANCELAR] = IR_A(AJUSTANDO_MINUTOS_ALARMA, NULL),
+        },
+    [PANTALLA_APAGADA] =
+        {
+            DESPERTAR,
+            [EVENTO_ALARMA_SONANDO] = IR_A(MOSTRANDO_HORA, EncenderSonando),
+            [EVENTO_ALARMA_CALLADA] = QUEDARSE(MarcarCallada),
+        },
+};
+
+static const entrada_s ENTRADAS[MODOS_CANTIDAD] = {
+    [SIN_CONFIGURAR] = {0, 3, 250},
+    [MOSTRANDO_HORA] = {0, 3, 0}, // digitos sin parpadear
+    [AJUSTANDO_MINUTOS_ACTUAL] = {2, 3, 250},
+    [AJUSTANDO_HORAS_ACTUAL] = {0, 1, 250},
+    [AJUSTANDO_MINUTOS_ALARMA] = {2, 3, 250},
+    [AJUSTANDO_HORAS_ALARMA] = {0, 1, 250},
+    [PANTALLA_APAGADA] = {0, 3, 0},
+};
+
+/* === Private function implementation ========================================================= */
+
+static modos_t ModosAllocate(void) {
+
+    static struct modos_s instances[1] = {0};
+    return &instances[0];
+}
+
+static void IncrementarBCD(uint8_t numero[2], const uint8_t limite[2]) {
+
+    numero[1]++;
+
+    // Corroboro antes si se llego al limite para que el ahora segundo if no me rompa la condicion
+    // de limite
+    if ((numero[0] == limite[0]) && (numero[1] > limite[1])) {
+        numero[0] = 0;
+        numero[1] = 0;
+    }
+
+    if (numero[1] > 9) {
+
+        numero[1] = 0;
+        numero[0]++;
+    }
+}
+
+// limite indica donde se pasa despues de restar 1 a 00
+static void DecrementarBCD(uint8_t numero[2], const uint8_t limite[2]) {
+
+    numero[1]--;
+
+    if ((numero[0] == 0) && ((int8_t)numero[1] < 0)) {
+        numero[0] = limite[0];
+        numero[1] = limite[1];
+    }
+    if ((int8_t)numero[1] < 0) {
+
+        numero[1] = 9;
+        numero[0]--;
+    }
+}
+
+static modo_t IncrementarMinutos(modos_t modos, modo_t siguiente) {
+
+    // le paso el puntero a los dos digitos menos significativos
+    IncrementarBCD(&modos->entrada[2], LIMITE_MINUTOS);
+    DisplayWriteBCD(modos->display, modos->entrada, sizeof(modos->entrada));
+    return siguiente;
+}
+
+static modo_t DecrementarMinutos(modos_t modos, modo_t siguiente) {
+
+    DecrementarBCD(&modos->entrada[2], LIMITE_MINUTOS);
+    DisplayWriteBCD(modos->display, modos->entrada, sizeof(modos->entrada));
+    return siguiente;
+}
+
+static modo_t IncrementarHoras(modos_t modos, modo_t siguiente) {
+
+    IncrementarBCD(modos->entrada, LIMITE_HORAS);
+    DisplayWriteBCD(modos->display, modos->entrada, sizeof(modos->entrada));
+    return siguiente;
+}
+
+static modo_t DecrementarHoras(modos_t modos, modo_t siguiente) {
+
+    DecrementarBCD(modos->entrada, LIMITE_HORAS);
+    DisplayWriteBCD(modos->display, modos->entrada, sizeof(modos->entrada));
+    return siguiente;
+}
+
+static modo_t EditarHora(modos_t modos, modo_t siguiente) {
+
+    GetClockTime(modos->reloj, modos->entrada, sizeof(modos->entrada));
+    DisplayClearDot(modos->display, DOT_1);
+    DisplayWriteBCD(modos->display, modos->entrada, sizeof(modos->entrada));
+    return siguiente;
+}
+
+static modo_t EditarAlarma(modos_t modos, modo_t siguiente) {
+
+    GetAlarmTime(modos->reloj, modos->entrada);
+    DisplaySetDot(modos->display, DOT_MASK);
+    DisplayWriteBCD(modos->display, modos->entrada, sizeof(modos->entrada));
+    return siguiente;
+}
+
+static modo_t GuardarHora(modos_t modos, modo_t siguiente) {
+
+    SetClockTime(modos->reloj, modos->entrada, sizeof(modos->entrada));
+    return siguiente;
+}
+
+static modo_t GuardarAlarma(modos_t modos, modo_t siguiente) {
+
+    DisplayClearDot(modos->display, DOT_0 | DOT_1 | DOT_2);
+    SetAlarmTime(modos->reloj, modos->entrada);
+    return siguiente;
+}
+
+// Sale del ajuste sin guardar: a mostrar la hora si el reloj ya tiene una hora valida
+static modo_t Descartar(modos_t modos, modo_t siguiente) {
+
+    if (!GetClockTime(modos->reloj, modos->entrada, sizeof(modos->entrada))) {
+        return SIN_CONFIGURAR;
+    }
+    DisplayClearDot(modos->display, DOT_MASK);
+    return siguiente;
+}
+
+static modo_t ActivarOPosponer(modos_t modos, modo_t siguiente) {
+
+    if (!GetAlarmTime(modos->reloj, modos->entrada)) {
+        ToggleHabAlarma(modos->reloj);
+        DisplaySetDot(modos->display, DOT_3);
+    } else if (modos->sonando) {
+        modos->sonando = false;
+        PosponerAlarma(modos->reloj, MINUTOS_POSPONER);
+    }
+    return siguiente;
+}
+
+static modo_t DesactivarOCancelar(modos_t modos, modo_t siguiente) {
+
+    if (modos->sonando) {
+        modos->sonando = false;
+        CancelarAlarma(modos->reloj);
+    } else if (GetAlarmTime(modos->reloj, modos->entrada)) {
+        ToggleHabAlarma(modos->reloj);
+        DisplayClearDot(modos->display, DOT_3);
+    }
+    return siguiente;
+}
+
+static modo_t MarcarSonando(modos_t modos, modo_t siguiente) {
+
+    modos->sonando = true;
+    return siguiente;
+}
+
+static modo_t MarcarCallada(modos_t modos, modo_t siguiente) {
+
+    modos->sonando = false;
+    return siguiente;
+}
+
+static modo_t Apagar(modos_t modos, modo_t siguiente) {
+
+    DisplaySetPower(modos->display, false);
+    return siguiente;
+}
+
+static modo_t Encender(modos_t modos, modo_t siguiente) {
+
+    DisplaySetPower(modos->display, true);
+    return siguiente;
+}
+
+static modo_t EncenderSonando(modos_t modos, modo_t siguiente) {
+
+    modos->sonando = true;
+    return Encender(modos, siguiente);
+}
+
+static void Entrar(modos_t modos, modo_t modo) {
+
+    const entrada_s * entrada = &ENTRADAS[modo];
+
+    modos->modo = modo;
+    DisplayFlashDigits(modos->display, entrada->desde, entrada->hasta, entrada->factor);
+}
+
+/* === Public function implementation ========================================================== */
+
+modos_t ModosCrear(reloj_t reloj, display_t display) {
+
+    modos_t modos = ModosAllocate();
+    modos->reloj = reloj;
+    modos->display = display;
+    modos->sonando = false;
+    for (int i = 0; i < DIGITOS_ENTRADA; i++) {
+        modos->entrada[i] = 0;
+    }
+    Entrar(modos, SIN_CONFIGURAR);
+
+    return modos;
+}
+
+modo_t ModosProcesar(modos_t modos, evento_t evento) {
+
+    if (evento >= EVENTOS_CANTIDAD) {
+        return modos->modo;
+    }
+
+    const transicion_s * transicion = &TRANSICIONES[modos->modo][evento];
+    modo_t siguiente = transicion->cambia ? transicion->siguiente : modos->modo;
+
+    if (transicion->accion) {
+        siguiente = transicion->accion(modos, siguiente);
+    }
+    if (transicion->cambia) {
+        Entrar(modos, siguiente);
+    }
+    return modos->modo;
+}
+
+modo_t ModosActual(modos_t modos) {
+
+    return modos->modo;
+}
+
+/* === End of documentation ==================================================================== */
+
+/** @} End of module definition for doxygen */
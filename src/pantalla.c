@@ -28,6 +28,7 @@ SPDX-License-Identifier: MIT
 #include "pantalla.h"
 #include "string.h"
 #include "reloj.h"
+#include <stdbool.h>
 
 /* === Macros definitions ====================================================================== */
 
@@ -45,11 +46,18 @@ struct display_s {
     // particular. DisplayRefresh accede a esa memoria, recorriendola, y sacando los segmentos de
     // cada digito en particular
     uint8_t memory[DISPLAY_MAX_DIGITS];
+    // Copia de 'memory' con los digitos que parpadean apagados. Se reconstruye solo cuando cambia
+    // 'memory' o el rango de parpadeo, asi DisplayRefresh no decide nada por cada digito.
+    uint8_t memory_off[DISPLAY_MAX_DIGITS];
+    uint8_t flashing_mask[DISPLAY_MAX_DIGITS]; // 0x00 en los digitos que parpadean, 0xFF en el resto
+    const uint8_t * frame; // imagen que se esta barriendo: memory o memory_off
     struct display_driver_s driver[1];
     uint8_t flashing_from;
     uint8_t flashing_to;
     uint16_t flashing_count;
     uint16_t flashing_factor;
+    uint16_t flashing_half; // flashing_factor / 2, precalculado
+    bool off;               // pantalla apagada por DisplaySetPower
 };
 
 /* === Private variable declarations =========================================================== */
@@ -67,10 +75,14 @@ static const uint8_t IMAGES[] = {
     SEGMENT_A | SEGMENT_B | SEGMENT_C | SEGMENT_F | SEGMENT_G,
 };
 
+static const uint8_t BLANK[DISPLAY_MAX_DIGITS] = {0};
+
 /* === Private function declarations =========================================================== */
 
 display_t DisplayAllocate();
 
+static void DisplayUpdateFrames(display_t display);
+
 /* === Public variable definitions ============================================================= */
 
 /* === Private variable definitions ============================================================ */
@@ -81,6 +93,19 @@ display_t DisplayAllocate() {
     static struct display_s instances[1] = {0};
     return &instances[0];
 }
+
+static void DisplayUpdateFrames(display_t display) {
+
+    for (int i = 0; i < DISPLAY_MAX_DIGITS; i++) {
+        display->memory_off[i] = display->memory[i] & display->flashing_mask[i];
+    }
+    if (display->driver->ScanFrames && display->off) {
+        display->driver->ScanFrames(BLANK, BLANK, display->digits, 0);
+    } else if (display->driver->ScanFrames) {
+        display->driver->ScanFrames(display->memory, display->memory_off, display->digits,
+                                    display->flashing_half * display->digits);
+    }
+}
 /* === Public function implementation ========================================================== */
 
 display_t DisplayCreate(uint8_t digits, display_driver_t driver) {
@@ -92,9 +117,15 @@ display_t DisplayCreate(uint8_t digits, display_driver_t driver) {
     display->flashing_factor = 0;
     display->flashing_from = 0;
     display->flashing_to = 0;
+    display->flashing_half = 0;
+    display->off = false;
+    display->frame = display->memory;
     memcpy(display->driver, driver, sizeof(display->driver));
     memset(display->memory, 0, sizeof(display->memory)); // limpia la memoria
+    memset(display->memory_off, 0, sizeof(display->memory_off));
+    memset(display->flashing_mask, 0xFF, sizeof(display->flashing_mask));
     display->driver->ScreenTurnOff();                    // apaga todos los digitos
+    DisplayUpdateFrames(display);
 
     return display;
 }
@@ -117,36 +148,30 @@ void DisplayWriteBCD(display_t display, uint8_t * numbers, uint8_t size) {
         // Me estaba cleareando el msb de memory (punto)
         (display->memory[i]) |= (IMAGES[numbers[i]]);
     }
+    DisplayUpdateFrames(display);
 }
 
 void DisplayRefresh(display_t display) {
-    // Suponiendo un duty factor de 50%: la primera mitad del segundo apago algunos digitos y la
-    // segunda mitad prendo todos
-
-    uint8_t segments = 0;
+    // El parpadeo solo elige, una vez por barrido completo, cual de las dos imagenes precalculadas
+    // se muestra. Con factor 0 ambas imagenes son iguales y la eleccion no tiene efecto.
 
     display->driver->ScreenTurnOff();
-    display->active_digit = (display->active_digit + 1) % display->digits;
-
-    segments = display->memory[display->active_digit];
-
-    if (display->flashing_factor) {
-
-        if (display->active_digit == 0) {
-            display->flashing_count = (display->flashing_count + 1) %
-                                      (display->flashing_factor); // f(display->flashing_factor +1)
-        }
+    if (display->off) {
+        return;
+    }
 
-        if (display->active_digit >= display->flashing_from &&
-            display->active_digit <= display->flashing_to) {
-            if (display->flashing_count > (display->flashing_factor / 2)) {
-                segments = 0;
-                // segments = display->memory[display->active_digit] & 0b10000000;
-            }
+    display->active_digit++;
+    if (display->active_digit == display->digits) {
+        display->active_digit = 0;
+        display->flashing_count++;
+        if (display->flashing_count == display->flashing_factor) {
+            display->flashing_count = 0;
         }
+        display->frame = (display->flashing_count > display->flashing_half) ? display->memory_off
+                                                                            : display->memory;
     }
 
-    display->driver->SegmentsTurnOn(segments);
+    display->driver->SegmentsTurnOn(display->frame[display->active_digit]);
     display->driver->DigitTurnOn(display->active_digit);
 }
 
@@ -157,11 +182,18 @@ void DisplayFlashDigits(display_t display, uint8_t from, uint8_t to, uint16_t fa
     display->flashing_to = to % (DISPLAY_MAX_DIGITS + 1);
     display->flashing_count = 0;
     display->flashing_factor = factor;
+    display->flashing_half = factor / 2;
+    for (int i = 0; i < DISPLAY_MAX_DIGITS; i++) {
+        bool flashing = factor && i >= display->flashing_from && i <= display->flashing_to;
+        display->flashing_mask[i] = flashing ? 0x00 : 0xFF;
+    }
+    DisplayUpdateFrames(display);
 }
 
 void DisplayToggleDot(display_t display, uint8_t digit_dot) {
 
     display->memory[digit_dot] ^= 1 << 7;
+    DisplayUpdateFrames(display);
 }
 
 void DisplaySetDot(display_t display, uint8_t digit_dot) {
@@ -173,6 +205,7 @@ void DisplaySetDot(display_t display, uint8_t digit_dot) {
         }
         mask <<= 1;
     }
+    DisplayUpdateFrames(display);
 }
 
 void DisplayClearDot(display_t display, uint8_t digit_dot) {
@@ -184,6 +217,16 @@ void DisplayClearDot(display_t display, uint8_t digit_dot) {
         }
         mask <<= 1;
     }
+    DisplayUpdateFrames(display);
+}
+
+void DisplaySetPower(display_t display, bool on) {
+
+    display->off = !on;
+    if (display->off) {
+        display->driver->ScreenTurnOff();
+    }
+    DisplayUpdateFrames(display);
 }
 
 /* === End of documentation ====================================================================
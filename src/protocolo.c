@@ -0,0 +1,479 @@
+/************************************************************************************************
+Copyright (c) 2023, Emiliano Arnedo <emiarnedo@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+
+/** \brief Protocolo binario para configurar el reloj por la consola
+ **
+ ** La recepcion es una maquina de estados que avanza un byte por vez en la interrupcion del
+ ** puerto serie: deshace el COBS, guarda el pedido y acumula el CRC, que sobre el mensaje junto
+ ** con su propio CRC da cero. Cada comando se resuelve con un acceso a una tabla, igual que los
+ ** eventos en los modos.
+ **
+ ** \addtogroup protocolo Protocolo
+ ** \brief Protocolo binario de configuracion remota
+ ** @{ */
+
+/* === Headers files inclusions =============================================================== */
+
+#include "protocolo.h"
+#include <stddef.h>
+
+/* === Macros definitions ====================================================================== */
+
+#define LARGO_CRC      2
+#define LARGO_CABECERA 2 // comando y secuencia
+#define LARGO_ESTADO   3 // comando, secuencia y estado de la respuesta
+#define LARGO_ALARMA   4 // hh mm dias banderas
+#define LARGO_LISTA    5 // alarma hh mm dias banderas
+#define SIN_ALARMA     (-1)
+
+/* === Private data type declarations ========================================================== */
+
+typedef enum {
+    LIBRE,     // se puede recibir un pedido
+    PEDIDO,    // hay un pedido sin ejecutar
+    RESPUESTA, // hay una respuesta sin enviar
+} estado_t;
+
+//! Funcion de un comando. Recibe los datos del pedido y agrega los de la respuesta con Responder.
+typedef uint8_t (*ejecutar_t)(protocolo_t protocolo, const uint8_t * datos, uint16_t largo);
+
+typedef struct comando_s {
+    ejecutar_t ejecutar;
+    uint16_t minimo; // largo minimo de los datos del pedido
+    uint16_t maximo; // largo maximo de los datos del pedido
+} comando_s;
+
+struct protocolo_s {
+    reloj_t reloj;
+    modos_t modos;
+    volatile estado_t estado;
+    bool en_trama;     // se recibio el delimitador inicial
+    bool vacia;        // no llego ningun byte despues del delimitador
+    bool descartar;    // la trama en curso no se guarda
+    bool cero;         // el bloque COBS en curso termina con un cero implicito
+    uint8_t restantes; // bytes que faltan del bloque COBS en curso
+    uint16_t crc;
+    uint16_t largo;        // bytes decodificados de la trama en curso
+    uint16_t largo_pedido; // bytes del pedido pendiente, no cambia con las tramas descartadas
+    uint8_t pedido[PROTOCOLO_MAX_TRAMA];
+    uint8_t mensaje[PROTOCOLO_MAX_TRAMA]; // respuesta sin codificar
+    uint16_t largo_mensaje;
+    uint8_t respuesta[PROTOCOLO_LARGO_CODIFICADO(PROTOCOLO_MAX_TRAMA - LARGO_CRC)];
+    uint16_t largo_respuesta;
+    volatile uint32_t descartadas;
+};
+
+/* === Private variable declarations =========================================================== */
+
+/* === Private function declarations =========================================================== */
+
+static uint16_t Crc(uint16_t crc, uint8_t dato);
+static void Empezar(protocolo_t protocolo);
+static void Guardar(protocolo_t protocolo, uint8_t dato);
+static bool Terminar(protocolo_t protocolo);
+static void Responder(protocolo_t protocolo, uint8_t dato);
+static bool Desempaquetar(uint8_t bcd, uint8_t limite, uint8_t digitos[2]);
+static uint8_t Empaquetar(const uint8_t digitos[2]);
+static bool LeerHora(const uint8_t * datos, uint8_t * hora, int campos);
+static bool LeerConfiguracion(const uint8_t * datos, struct alarma_config_s * config);
+static void BorrarTodas(reloj_t reloj);
+static uint8_t ComandoLeerEstado(protocolo_t protocolo, const uint8_t * datos, uint16_t largo);
+static uint8_t ComandoFijarHora(protocolo_t protocolo, const uint8_t * datos, uint16_t largo);
+static uint8_t ComandoAgregarAlarma(protocolo_t protocolo, const uint8_t * datos, uint16_t largo);
+static uint8_t ComandoBorrarAlarma(protocolo_t protocolo, const uint8_t * datos, uint16_t largo);
+static uint8_t ComandoListarAlarmas(protocolo_t protocolo, const uint8_t * datos, uint16_t largo);
+static uint8_t ComandoConfigurar(protocolo_t protocolo, const uint8_t * datos, uint16_t largo);
+
+/* === Public variable definitions ============================================================= */
+
+/* === Private variable definitions ============================================================ */
+
+// CRC-16/CCITT de cada nibble, para calcularlo con dos accesos a la tabla por byte
+static const uint16_t CRC_NIBBLE[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+};
+
+// Limites en BCD empaquetado de las horas, los minutos y los segundos
+static const uint8_t LIMITES_HORA[] = {0x23, 0x59, 0x59};
+
+static const comando_s COMANDOS[] = {
+    [PROTOCOLO_LEER_ESTADO] = {ComandoLeerEstado, 0, 0},
+    [PROTOCOLO_FIJAR_HORA] = {ComandoFijarHora, 3, 4},
+    [PROTOCOLO_AGREGAR_ALARMA] = {ComandoAgregarAlarma, LARGO_ALARMA, LARGO_ALARMA},
+    [PROTOCOLO_BORRAR_ALARMA] = {ComandoBorrarAlarma, 1, 1},
+    [PROTOCOLO_LISTAR_ALARMAS] = {ComandoListarAlarmas, 0, 1},
+    [PROTOCOLO_CONFIGURAR] = {ComandoConfigurar, 4, PROTOCOLO_MAX_TRAMA},
+};
+
+/* === Private function implementation ========================================================= */
+
+static uint16_t Crc(uint16_t crc, uint8_t dato) {
+
+    crc = (crc << 4) ^ CRC_NIBBLE[(crc >> 12) ^ (dato >> 4)];
+    crc = (crc << 4) ^ CRC_NIBBLE[(crc >> 12) ^ (dato & 0x0F)];
+    return crc;
+}
+
+// Con el delimitador inicial. Si hay un pedido o una respuesta pendiente la trama se descarta.
+static void Empezar(protocolo_t protocolo) {
+
+    protocolo->en_trama = true;
+    protocolo->vacia = true;
+    protocolo->descartar = (protocolo->estado != LIBRE);
+    protocolo->cero = false;
+    protocolo->restantes = 0;
+    protocolo->crc = 0xFFFF;
+    protocolo->largo = 0;
+}
+
+static void Guardar(protocolo_t protocolo, uint8_t dato) {
+
+    if (protocolo->descartar) {
+        return;
+    }
+    if (protocolo->largo < sizeof(protocolo->pedido)) {
+        protocolo->pedido[protocolo->largo++] = dato;
+        protocolo->crc = Crc(protocolo->crc, dato);
+    } else {
+        protocolo->descartar = true;
+    }
+}
+
+// Con el delimitador final. El pedido vale si el ultimo bloque COBS esta completo y el CRC da cero.
+static bool Terminar(protocolo_t protocolo) {
+
+    bool valido = !protocolo->descartar && (protocolo->restantes == 0) &&
+                  (protocolo->largo >= LARGO_CABECERA + LARGO_CRC) && (protocolo->crc == 0);
+
+    protocolo->en_trama = false;
+    if (valido) {
+        protocolo->largo_pedido = protocolo->largo;
+        protocolo->estado = PEDIDO;
+    } else {
+        protocolo->descartadas++;
+    }
+    return valido;
+}
+
+static void Responder(protocolo_t protocolo, uint8_t dato) {
+
+    if (protocolo->largo_mensaje < sizeof(protocolo->mensaje) - LARGO_CRC) {
+        protocolo->mensaje[protocolo->largo_mensaje++] = dato;
+    }
+}
+
+static bool Desempaquetar(uint8_t bcd, uint8_t limite, uint8_t digitos[2]) {
+
+    digitos[0] = bcd >> 4;
+    digitos[1] = bcd & 0x0F;
+    return (digitos[1] <= 9) && (bcd <= limite);
+}
+
+static uint8_t Empaquetar(const uint8_t digitos[2]) {
+
+    return (digitos[0] << 4) | digitos[1];
+}
+
+// Convierte hh mm (campos = 2) o hh mm ss (campos = 3) en los digitos BCD que usa el reloj
+static bool LeerHora(const uint8_t * datos, uint8_t * hora, int campos) {
+
+    bool valida = true;
+
+    for (int i = 0; i < campos; i++) {
+        valida &= Desempaquetar(datos[i], LIMITES_HORA[i], &hora[2 * i]);
+    }
+    return valida;
+}
+
+static bool LeerConfiguracion(const uint8_t * datos, struct alarma_config_s * config) {
+
+    config->dias = datos[2];
+    config->repetir = (datos[3] & PROTOCOLO_REPETIR) != 0;
+    return LeerHora(datos, config->hora, 2) && (datos[2] <= ALARMA_TODOS_LOS_DIAS);
+}
+
+// Se borran de la ultima a la primera para que las alarmas nuevas vuelvan a usar la tabla en orden
+static void BorrarTodas(reloj_t reloj) {
+
+    for (int i = ALARM_INSTANCES - 1; i >= 0; i--) {
+        BorrarAlarma(reloj, i);
+    }
+}
+
+static uint8_t ComandoLeerEstado(protocolo_t protocolo, const uint8_t * datos, uint16_t largo) {
+
+    struct alarma_config_s config;
+    uint8_t hora[6];
+    uint8_t alarmas = 0;
+    bool valida, programada;
+
+    (void)datos;
+    (void)largo;
+    valida = GetClockTime(protocolo->reloj, hora, sizeof(hora));
+    for (int i = 0; i < ALARM_INSTANCES; i++) {
+        alarmas += LeerAlarma(protocolo->reloj, i, &config, &programada);
+    }
+    Responder(protocolo, Empaquetar(&hora[0]));
+    Responder(protocolo, Empaquetar(&hora[2]));
+    Responder(protocolo, Empaquetar(&hora[4]));
+    Responder(protocolo, GetClockWeekday(protocolo->reloj));
+    Responder(protocolo, valida);
+    Responder(protocolo, (uint8_t)AlarmaSonando(protocolo->reloj)); // SIN_ALARMA es 0xFF
+    Responder(protocolo, alarmas);
+    Responder(protocolo, ModosActual(protocolo->modos));
+    return PROTOCOLO_OK;
+}
+
+static uint8_t ComandoFijarHora(protocolo_t protocolo, const uint8_t * datos, uint16_t largo) {
+
+    uint8_t hora[6];
+
+    if (!LeerHora(datos, hora, 3) || ((largo > 3) && (datos[3] > 6))) {
+        return PROTOCOLO_VALOR_ERRONEO;
+    }
+    SetClockTime(protocolo->reloj, hora, sizeof(hora));
+    if (largo > 3) {
+        SetClockWeekday(protocolo->reloj, datos[3]);
+    }
+    ModosProcesar(protocolo->modos, EVENTO_HORA_CONFIGURADA);
+    return PROTOCOLO_OK;
+}
+
+static uint8_t ComandoAgregarAlarma(protocolo_t protocolo, const uint8_t * datos, uint16_t largo) {
+
+    struct alarma_config_s config;
+    int alarma;
+
+    (void)largo;
+    if (!LeerConfiguracion(datos, &config)) {
+        return PROTOCOLO_VALOR_ERRONEO;
+    }
+    alarma = AgregarAlarma(protocolo->reloj, &config);
+    if (alarma == SIN_ALARMA) {
+        return PROTOCOLO_TABLA_LLENA;
+    }
+    Responder(protocolo, alarma);
+    return PROTOCOLO_OK;
+}
+
+static uint8_t ComandoBorrarAlarma(protocolo_t protocolo, const uint8_t * datos, uint16_t largo) {
+
+    (void)largo;
+    if (datos[0] == PROTOCOLO_TODAS) {
+        BorrarTodas(protocolo->reloj);
+    } else if (!BorrarAlarma(protocolo->reloj, datos[0])) {
+        return PROTOCOLO_VALOR_ERRONEO;
+    }
+    return PROTOCOLO_OK;
+}
+
+// Lista las alarmas desde la indicada hasta que se llena la respuesta. Si la tabla tiene mas
+// alarmas de las que entran, se pide de nuevo desde la siguiente a la ultima recibida.
+static uint8_t ComandoListarAlarmas(protocolo_t protocolo, const uint8_t * datos, uint16_t largo) {
+
+    struct alarma_config_s config;
+    bool programada;
+
+    for (int i = largo ? datos[0] : 0; i < ALARM_INSTANCES; i++) {
+        if (protocolo->largo_mensaje > sizeof(protocolo->mensaje) - LARGO_CRC - LARGO_LISTA) {
+            break;
+        }
+        if (LeerAlarma(protocolo->reloj, i, &config, &programada)) {
+            Responder(protocolo, i);
+            Responder(protocolo, Empaquetar(&config.hora[0]));
+            Responder(protocolo, Empaquetar(&config.hora[2]));
+            Responder(protocolo, config.dias);
+            Responder(protocolo, (config.repetir ? PROTOCOLO_REPETIR : 0) |
+                                     (programada ? PROTOCOLO_PROGRAMADA : 0));
+        }
+    }
+    return PROTOCOLO_OK;
+}
+
+// Reemplaza la hora y toda la tabla de alarmas en un solo pedido. Se verifica todo antes de
+// cambiar algo, asi un pedido con errores deja el reloj como estaba.
+static uint8_t ComandoConfigurar(protocolo_t protocolo, const uint8_t * datos, uint16_t largo) {
+
+    struct alarma_config_s config;
+    uint16_t alarmas = (largo - 4) / LARGO_ALARMA;
+    uint8_t hora[6];
+
+    if ((largo - 4) % LARGO_ALARMA) {
+        return PROTOCOLO_LARGO_ERRONEO;
+    }
+    if (!LeerHora(datos, hora, 3) || (datos[3] > 6)) {
+        return PROTOCOLO_VALOR_ERRONEO;
+    }
+    for (int i = 0; i < alarmas; i++) {
+        if (!LeerConfiguracion(&datos[4 + i * LARGO_ALARMA], &config)) {
+            return PROTOCOLO_VALOR_ERRONEO;
+        }
+    }
+    if (alarmas > ALARM_INSTANCES) {
+        return PROTOCOLO_TABLA_LLENA;
+    }
+
+    BorrarTodas(protocolo->reloj);
+    SetClockTime(protocolo->reloj, hora, sizeof(hora));
+    SetClockWeekday(protocolo->reloj, datos[3]);
+    for (int i = 0; i < alarmas; i++) {
+        LeerConfiguracion(&datos[4 + i * LARGO_ALARMA], &config);
+        Responder(protocolo, AgregarAlarma(protocolo->reloj, &config));
+    }
+    ModosProcesar(protocolo->modos, EVENTO_HORA_CONFIGURADA);
+    return PROTOCOLO_OK;
+}
+
+/* === Public function implementation ========================================================== */
+
+protocolo_t ProtocoloCrear(reloj_t reloj, modos_t modos) {
+
+    static struct protocolo_s instancias[1] = {0};
+    protocolo_t protocolo = &instancias[0];
+
+    protocolo->reloj = reloj;
+    protocolo->modos = modos;
+    protocolo->estado = LIBRE;
+    protocolo->en_trama = false;
+    protocolo->largo_respuesta = 0;
+    protocolo->descartadas = 0;
+    return protocolo;
+}
+
+protocolo_recepcion_t ProtocoloRecibir(protocolo_t protocolo, uint8_t dato) {
+
+    protocolo_recepcion_t resultado = PROTOCOLO_TRAMA;
+
+    if (dato == 0) {
+        // Varios ceros seguidos son un solo delimitador
+        if (!protocolo->en_trama || protocolo->vacia) {
+            Empezar(protocolo);
+        } else if (Terminar(protocolo)) {
+            resultado = PROTOCOLO_PEDIDO;
+        }
+    } else if (!protocolo->en_trama) {
+        resultado = PROTOCOLO_TEXTO;
+    } else {
+        // Cada bloque COBS empieza con un codigo: la cantidad de bytes que siguen mas uno. Salvo
+        // despues de un bloque completo (0xFF), el bloque anterior terminaba en un cero.
+        protocolo->vacia = false;
+        if (protocolo->restantes == 0) {
+            if (protocolo->cero) {
+                Guardar(protocolo, 0);
+            }
+            protocolo->restantes = dato - 1;
+            protocolo->cero = (dato != 0xFF);
+        } else {
+            Guardar(protocolo, dato);
+            protocolo->restantes--;
+        }
+    }
+    return resultado;
+}
+
+bool ProtocoloEjecutar(protocolo_t protocolo) {
+
+    const uint8_t * pedido = protocolo->pedido;
+    const comando_s * comando = NULL;
+    uint16_t largo;
+    uint8_t estado;
+
+    if (protocolo->estado != PEDIDO) {
+        return false;
+    }
+    largo = protocolo->largo_pedido - LARGO_CABECERA - LARGO_CRC;
+    if (pedido[0] < sizeof(COMANDOS) / sizeof(COMANDOS[0])) {
+        comando = &COMANDOS[pedido[0]];
+    }
+
+    protocolo->mensaje[0] = pedido[0] | PROTOCOLO_RESPUESTA;
+    protocolo->mensaje[1] = pedido[1];
+    protocolo->largo_mensaje = LARGO_ESTADO;
+    if ((comando == NULL) || (comando->ejecutar == NULL)) {
+        estado = PROTOCOLO_DESCONOCIDO;
+    } else if ((largo < comando->minimo) || (largo > comando->maximo)) {
+        estado = PROTOCOLO_LARGO_ERRONEO;
+    } else {
+        estado = comando->ejecutar(protocolo, &pedido[LARGO_CABECERA], largo);
+    }
+    // Una respuesta con error no lleva datos
+    protocolo->mensaje[2] = estado;
+    if (estado != PROTOCOLO_OK) {
+        protocolo->largo_mensaje = LARGO_ESTADO;
+    }
+
+    protocolo->largo_respuesta =
+        ProtocoloCodificar(protocolo->mensaje, protocolo->largo_mensaje, protocolo->respuesta);
+    protocolo->estado = RESPUESTA;
+    return true;
+}
+
+uint16_t ProtocoloRespuesta(protocolo_t protocolo, const uint8_t ** datos) {
+
+    *datos = protocolo->respuesta;
+    return (protocolo->estado == RESPUESTA) ? protocolo->largo_respuesta : 0;
+}
+
+void ProtocoloLiberar(protocolo_t protocolo) {
+
+    protocolo->largo_pedido = 0;
+    protocolo->largo_respuesta = 0;
+    protocolo->estado = LIBRE;
+}
+
+const volatile uint32_t * ProtocoloDescartadas(protocolo_t protocolo) {
+
+    return &protocolo->descartadas;
+}
+
+// COBS: cada cero del mensaje se reemplaza por la distancia al cero siguiente, y los bloques sin
+// ceros se cortan cada 254 bytes
+uint16_t ProtocoloCodificar(uint8_t * datos, uint16_t largo, uint8_t * trama) {
+
+    uint16_t crc = 0xFFFF;
+    uint16_t codigo = 1; // posicion del codigo del bloque en curso
+    uint16_t salida = 2;
+
+    for (int i = 0; i < largo; i++) {
+        crc = Crc(crc, datos[i]);
+    }
+    datos[largo] = crc >> 8;
+    datos[largo + 1] = crc & 0xFF;
+
+    trama[0] = 0;
+    for (int i = 0; i < largo + LARGO_CRC; i++) {
+        if (datos[i] == 0) {
+            trama[codigo] = salida - codigo;
+            codigo = salida++;
+        } else {
+            trama[salida++] = datos[i];
+            if (salida - codigo == 0xFF) {
+                trama[codigo] = 0xFF;
+                codigo = salida++;
+            }
+        }
+    }
+    trama[codigo] = salida - codigo;
+    trama[salida++] = 0;
+    return salida;
+}
+
+/* === End of documentation ==================================================================== */
+
+/** @} End of module definition for doxygen */
@@ -22,19 +22,60 @@ SPDX-License-Identifier: MIT
 
 /* === Macros definitions ====================================================================== */
 
+#define SEGUNDOS_POR_DIA 86400
+
+#define SIN_ALARMA (-1)
+
+// Los indices de las alarmas y sus posiciones en el monticulo se guardan en un byte
+_Static_assert(ALARM_INSTANCES <= 255, "ALARM_INSTANCES no puede superar 255");
+
+// Campos de la hora publicada para los lectores: segundos desde la medianoche (menos de 2^17),
+// dia de la semana y si la hora es valida
+#define PUBLICADA_SEGUNDOS 0x1FFFF
+#define PUBLICADA_DIA      17
+#define PUBLICADA_VALIDA   (1u << 31)
+
 /* === Private data type declarations ========================================================== */
 
+typedef struct alarma_s {
+    uint32_t hora;         // hora de la alarma en segundos desde la medianoche
+    uint32_t disparo;      // instante absoluto del proximo disparo, incluido el snooze
+    uint32_t ultimo;       // instante absoluto del ultimo disparo
+    uint32_t snooze;       // tiempo acumulado por PosponerAlarma desde el ultimo disparo
+    uint8_t dias;          // mascara de dias de la semana en que suena
+    uint8_t posicion;      // indice de la alarma dentro del monticulo
+    bool asignada : 1;     // la entrada de la tabla esta en uso
+    bool repetir : 1;      // false: suena una sola vez
+    bool en_monticulo : 1; // la alarma esta programada
+} * alarma_t;
+
 typedef struct reloj_s {
 
-    uint8_t hora_actual[6];
-    bool hora_valida : 1;
+    uint32_t segundos;      // hora actual en segundos desde la medianoche
+    uint32_t instante;      // segundos transcurridos desde la creacion del reloj
+    uint8_t dia_semana;     // 0 = domingo
+    bool hora_valida;
+    // Copia de segundos, dia_semana y hora_valida en una sola palabra, que el escritor actualiza
+    // de una vez despues de cada cambio. Los lectores de otras tareas la leen tambien de una vez,
+    // asi nunca ven una hora a medio actualizar y no bloquean al escritor.
+    volatile uint32_t publicada;
     int ticks; // cantidad de interrupciones antes de aumentar un segundo
-    int tick_actual;
+    uint32_t tick_contador;   // contador monotono propio, lo avanza RelojNuevoTick
+    uint32_t tick_referencia; // valor del contador absoluto en que empezo el segundo actual
     /***********************/
-    uint8_t alarma[4];
-    bool alarma_habilitada : 1;
     callback_disparar disparar_alarma;
-    uint32_t snooze_offset; // tiempo que se suma a alarma al momento de compararse con hora_actual
+    struct alarma_s alarmas[ALARM_INSTANCES];
+    // Monticulo binario con los indices de las alarmas programadas, ordenado por 'disparo'. La
+    // proxima alarma a sonar siempre esta en monticulo[0].
+    uint8_t monticulo[ALARM_INSTANCES];
+    uint8_t programadas; // cantidad de alarmas en el monticulo
+    // Pila con los indices de las entradas libres de la tabla, asi agregar una alarma no recorre
+    // la tabla. La proxima entrada a usar esta en libres[cantidad_libres - 1].
+    uint8_t libres[ALARM_INSTANCES];
+    uint8_t cantidad_libres;
+    int principal;       // alarma que manejan SetAlarmTime, GetAlarmTime y ToggleHabAlarma
+    int sonando;         // ultima alarma que se disparo
+    reloj_fuente_t fuente; // NULL si el contador lo entrega quien llama a ClockGetTimeAt
 
 } reloj_s;
 /* === Private variable declarations =========================================================== */
@@ -42,45 +83,53 @@ typedef struct reloj_s {
 // uint8_t hora_actual[] = {0};
 
 /* === Private function declarations =========================================================== */
-void NuevoSegundo(reloj_t reloj);
+static void SaltarSegundos(reloj_t reloj, uint32_t segundos);
+
+uint32_t DataTimeASeg(const uint8_t * data_time);
+
+static void ExpandirHora(uint32_t segundos, uint8_t hora[6]);
+
+static void Publicar(reloj_t reloj);
+
+static void AvanzarHasta(reloj_t reloj, uint32_t tick_count);
+
+static bool Precede(reloj_t reloj, uint8_t a, uint8_t b);
 
-uint32_t DataTimeASeg(uint8_t * data_time);
+static void Intercambiar(reloj_t reloj, uint8_t a, uint8_t b);
+
+static void Subir(reloj_t reloj, uint8_t posicion);
+
+static void Bajar(reloj_t reloj, uint8_t posicion);
+
+static void Programar(reloj_t reloj, int indice, uint32_t disparo);
+
+static void Desprogramar(reloj_t reloj, int indice);
+
+static uint32_t ProximoDisparo(reloj_t reloj, alarma_t alarma);
+
+static void Reprogramar(reloj_t reloj);
 /* === Public variable definitions ============================================================= */
 
 /* === Private variable definitions ============================================================ */
 
 /* === Private function implementation ========================================================= */
-void NuevoSegundo(reloj_t reloj) {
-
-    reloj->hora_actual[5]++; // incrementa en 1 los segundos
-                             // false: si se superaron las 10 horas
-
-    if (reloj->hora_actual[5] == 10) {
-        reloj->hora_actual[5] = 0;
-        reloj->hora_actual[4]++; // incrementan las decenas de segundos
-        if (reloj->hora_actual[4] == 6) {
-            reloj->hora_actual[4] = 0;
-            reloj->hora_actual[3]++; // incrementan los minutos
-            if (reloj->hora_actual[3] == 10) {
-                reloj->hora_actual[3] = 0;
-                reloj->hora_actual[2]++; // incrementan las decenas de minutos
-                if (reloj->hora_actual[2] == 6) {
-                    reloj->hora_actual[2] = 0;
-                    reloj->hora_actual[1]++; // incrementan las horas
-                    if (reloj->hora_actual[1] == 10 && reloj->hora_actual[0] < 2) {
-                        reloj->hora_actual[1] = 0;
-                        reloj->hora_actual[0]++; // incrementan las decenas
-                    } else if (reloj->hora_actual[1] == 4 && reloj->hora_actual[0] == 2) {
-                        reloj->hora_actual[1] = 0;
-                        reloj->hora_actual[0] = 0;
-                    }
-                }
-            }
-        }
+// Adelanta la hora y el dia de la semana de una vez, sin pasar por cada segundo. O(1)
+static void SaltarSegundos(reloj_t reloj, uint32_t segundos) {
+
+    uint32_t dias = segundos / SEGUNDOS_POR_DIA;
+    uint32_t hora = reloj->segundos + segundos % SEGUNDOS_POR_DIA;
+
+    if (hora >= SEGUNDOS_POR_DIA) {
+        hora -= SEGUNDOS_POR_DIA;
+        dias++;
     }
+    reloj->instante += segundos;
+    reloj->segundos = hora;
+    reloj->dia_semana = (reloj->dia_semana + dias % 7) % 7;
+    Publicar(reloj);
 }
 // Convierte cualquier array de 4 bytes a un entero sin signo
-uint32_t DataTimeASeg(uint8_t * data_time) {
+uint32_t DataTimeASeg(const uint8_t * data_time) {
 
     // data_time debe tener 4 elementos como minimo, corregir para que no haya comportamiento
     // indefinido si se pasaran menos elementos
@@ -88,6 +137,179 @@ uint32_t DataTimeASeg(uint8_t * data_time) {
                              (data_time[2] * 10 * 60) + (data_time[3] * 60);
     return data_time_seg;
 }
+
+// Convierte los segundos desde la medianoche en los digitos BCD hh:mm:ss
+static void ExpandirHora(uint32_t segundos, uint8_t hora[6]) {
+
+    uint32_t horas = segundos / 3600;
+    uint32_t minutos = (segundos / 60) % 60;
+
+    segundos = segundos % 60;
+    hora[0] = horas / 10;
+    hora[1] = horas % 10;
+    hora[2] = minutos / 10;
+    hora[3] = minutos % 10;
+    hora[4] = segundos / 10;
+    hora[5] = segundos % 10;
+}
+
+// Un unico store de 32 bits, atomico en Cortex-M y en el host
+static void Publicar(reloj_t reloj) {
+
+    reloj->publicada = (reloj->hora_valida ? PUBLICADA_VALIDA : 0) |
+                       ((uint32_t)reloj->dia_semana << PUBLICADA_DIA) | reloj->segundos;
+}
+
+// Lleva el reloj hasta el instante tick_count de un contador monotono. Todos los segundos
+// completos transcurridos desde tick_referencia se suman de una vez, por lo que despertar tarde no
+// pierde segundos ni cuesta mas. Solo se detiene en el instante de cada alarma que quede en el
+// medio, para dispararlas en orden y con la hora en que suenan.
+static void AvanzarHasta(reloj_t reloj, uint32_t tick_count) {
+    uint32_t transcurridos = tick_count - reloj->tick_referencia; // aritmetica modular: soporta
+                                                                  // el desborde del contador
+    uint32_t segundos, destino, disparo;
+
+    if (transcurridos < (uint32_t)reloj->ticks) {
+        return; // el caso mas comun: todavia no termino el segundo
+    }
+    segundos = transcurridos / reloj->ticks;
+    reloj->tick_referencia += segundos * reloj->ticks;
+    if (reloj->hora_valida == false) {
+        // Sin hora valida solo se mantiene la fase del segundo, no hay nada que contar
+        return;
+    }
+
+    destino = reloj->instante + segundos;
+    while (reloj->programadas > 0) {
+        disparo = reloj->alarmas[reloj->monticulo[0]].disparo;
+        if (disparo > destino) {
+            break;
+        }
+        if (disparo > reloj->instante) {
+            SaltarSegundos(reloj, disparo - reloj->instante);
+        }
+        VerificarAlarma(reloj);
+    }
+    SaltarSegundos(reloj, destino - reloj->instante);
+}
+
+// Orden del monticulo: primero el disparo mas cercano, a igual disparo el indice menor
+static bool Precede(reloj_t reloj, uint8_t a, uint8_t b) {
+
+    uint32_t disparo_a = reloj->alarmas[a].disparo;
+    uint32_t disparo_b = reloj->alarmas[b].disparo;
+
+    return (disparo_a < disparo_b) || ((disparo_a == disparo_b) && (a < b));
+}
+
+static void Intercambiar(reloj_t reloj, uint8_t a, uint8_t b) {
+
+    uint8_t temporal = reloj->monticulo[a];
+    reloj->monticulo[a] = reloj->monticulo[b];
+    reloj->monticulo[b] = temporal;
+    reloj->alarmas[reloj->monticulo[a]].posicion = a;
+    reloj->alarmas[reloj->monticulo[b]].posicion = b;
+}
+
+static void Subir(reloj_t reloj, uint8_t posicion) {
+
+    while (posicion > 0) {
+        uint8_t padre = (posicion - 1) / 2;
+        if (!Precede(reloj, reloj->monticulo[posicion], reloj->monticulo[padre])) {
+            break;
+        }
+        Intercambiar(reloj, posicion, padre);
+        posicion = padre;
+    }
+}
+
+static void Bajar(reloj_t reloj, uint8_t posicion) {
+
+    while (true) {
+        // Los hijos de las posiciones altas no entran en un byte
+        uint8_t menor = posicion;
+        uint16_t izquierdo = 2 * posicion + 1;
+        uint16_t derecho = izquierdo + 1;
+
+        if ((izquierdo < reloj->programadas) &&
+            Precede(reloj, reloj->monticulo[izquierdo], reloj->monticulo[menor])) {
+            menor = izquierdo;
+        }
+        if ((derecho < reloj->programadas) &&
+            Precede(reloj, reloj->monticulo[derecho], reloj->monticulo[menor])) {
+            menor = derecho;
+        }
+        if (menor == posicion) {
+            break;
+        }
+        Intercambiar(reloj, posicion, menor);
+        posicion = menor;
+    }
+}
+
+// Inserta la alarma en el monticulo o, si ya estaba, actualiza su disparo. O(log n)
+static void Programar(reloj_t reloj, int indice, uint32_t disparo) {
+
+    alarma_t alarma = &reloj->alarmas[indice];
+
+    alarma->disparo = disparo;
+    if (!alarma->en_monticulo) {
+        alarma->en_monticulo = true;
+        alarma->posicion = reloj->programadas;
+        reloj->monticulo[reloj->programadas] = indice;
+        reloj->programadas++;
+    }
+    Subir(reloj, alarma->posicion);
+    Bajar(reloj, alarma->posicion);
+}
+
+// Quita la alarma del monticulo reemplazandola por la ultima hoja. O(log n)
+static void Desprogramar(reloj_t reloj, int indice) {
+
+    alarma_t alarma = &reloj->alarmas[indice];
+    uint8_t posicion = alarma->posicion;
+
+    if (!alarma->en_monticulo) {
+        return;
+    }
+    alarma->en_monticulo = false;
+    reloj->programadas--;
+    if (posicion != reloj->programadas) {
+        reloj->monticulo[posicion] = reloj->monticulo[reloj->programadas];
+        reloj->alarmas[reloj->monticulo[posicion]].posicion = posicion;
+        Subir(reloj, posicion);
+        Bajar(reloj, posicion);
+    }
+}
+
+// Busca, a partir del dia actual, el primer dia habilitado en que la alarma todavia no paso
+static uint32_t ProximoDisparo(reloj_t reloj, alarma_t alarma) {
+
+    uint32_t disparo = reloj->instante - reloj->segundos + alarma->hora;
+    uint8_t dia = reloj->dia_semana;
+
+    for (int i = 0; i < 8; i++) {
+        if ((disparo > reloj->instante) && (alarma->dias & (1 << dia))) {
+            break;
+        }
+        disparo += SEGUNDOS_POR_DIA;
+        dia = (dia == 6) ? 0 : dia + 1;
+    }
+    return disparo;
+}
+
+// Recalcula todos los disparos cuando cambia la hora o el dia. O(n)
+static void Reprogramar(reloj_t reloj) {
+
+    for (int i = 0; i < reloj->programadas; i++) {
+        alarma_t alarma = &reloj->alarmas[reloj->monticulo[i]];
+        alarma->snooze = 0;
+        alarma->disparo = ProximoDisparo(reloj, alarma);
+    }
+    for (int i = reloj->programadas / 2; i > 0; i--) {
+        Bajar(reloj, i - 1);
+    }
+}
 /* === Public function implementation ========================================================== */
 
 reloj_t ClockCreate(int ticks_por_segundo, callback_disparar funcion_de_disparo) {
@@ -96,95 +318,268 @@ reloj_t ClockCreate(int ticks_por_segundo, callback_disparar funcion_de_disparo)
     memset(self, 0, sizeof(self));
     self->ticks = ticks_por_segundo;
     self->disparar_alarma = funcion_de_disparo;
+    self->principal = SIN_ALARMA;
+    self->sonando = SIN_ALARMA;
+    // Las entradas se usan desde la primera mientras no se borre ninguna
+    for (int i = 0; i < ALARM_INSTANCES; i++) {
+        self->libres[i] = ALARM_INSTANCES - 1 - i;
+    }
+    self->cantidad_libres = ALARM_INSTANCES;
     return self;
 }
 
+reloj_t ClockCreateFromSource(reloj_fuente_t fuente, callback_disparar funcion_de_disparo) {
+
+    reloj_t self = ClockCreate(fuente->frecuencia, funcion_de_disparo);
+    if (fuente->Iniciar) {
+        fuente->Iniciar();
+    }
+    self->fuente = fuente;
+    self->tick_referencia = fuente->Leer();
+    return self;
+}
+
+// Se puede llamar desde cualquier tarea mientras otra actualiza el reloj: solo lee la palabra
+// publicada, sin tocar el estado del reloj
 bool GetClockTime(reloj_t reloj, uint8_t * hora, int size) {
 
-    // memset(hora, 0, size);
-    memcpy(hora, reloj->hora_actual, size);
+    uint32_t publicada = reloj->publicada;
+    uint8_t vista[6];
 
-    return reloj->hora_valida;
+    if (size > (int)sizeof(vista)) {
+        size = sizeof(vista);
+    }
+    ExpandirHora(publicada & PUBLICADA_SEGUNDOS, vista);
+    memcpy(hora, vista, size);
+
+    return (publicada & PUBLICADA_VALIDA) != 0;
 }
 
 bool SetClockTime(reloj_t reloj, const uint8_t * hora_nueva, int size) {
 
-    memcpy(reloj->hora_actual, hora_nueva, size);
+    uint8_t vista[6];
+
+    if (size > (int)sizeof(vista)) {
+        size = sizeof(vista);
+    }
+    // Los digitos que no se informan (ej: segundos cuando size = 4) conservan su valor
+    ExpandirHora(reloj->segundos, vista);
+    memcpy(vista, hora_nueva, size);
+    reloj->instante -= reloj->segundos;
+    reloj->segundos = DataTimeASeg(vista) + vista[4] * 10 + vista[5];
+    reloj->instante += reloj->segundos;
     reloj->hora_valida = true; // indica que la hora actual del reloj es válida
+    Publicar(reloj);
+    Reprogramar(reloj);
 
     return true; // hace falta retornar una confirmacion?
 }
 
-// En principio esta funcion es la que llama el systick en cada interrupcion
+bool SetClockWeekday(reloj_t reloj, uint8_t dia_semana) {
+
+    if (dia_semana > 6) {
+        return false;
+    }
+    reloj->dia_semana = dia_semana;
+    Publicar(reloj);
+    Reprogramar(reloj);
+    return true;
+}
+
+uint8_t GetClockWeekday(reloj_t reloj) {
+
+    return (reloj->publicada >> PUBLICADA_DIA) & 0x07;
+}
+
+// Avanza el reloj un tick usando su propio contador. Se mantiene por compatibilidad, las tareas
+// deberian usar ClockUpdate con su fuente de tiempo.
 int RelojNuevoTick(reloj_t reloj) {
 
-    if ((reloj->tick_actual >= (reloj->ticks - 1))) { // if ((reloj->tick_actual >= reloj->ticks)) {
-        if (reloj->hora_valida == true) {
-            NuevoSegundo(reloj);
-            VerificarAlarma(reloj);
+    return RelojAdvance(reloj, 1);
+}
+
+int RelojAdvance(reloj_t reloj, uint32_t n_ticks) {
+
+    reloj->tick_contador += n_ticks;
+    return ClockGetTimeAt(reloj, reloj->tick_contador);
+}
+
+int ClockGetTimeAt(reloj_t reloj, uint32_t tick_count) {
+
+    AvanzarHasta(reloj, tick_count);
+    return tick_count - reloj->tick_referencia; // ticks transcurridos dentro del segundo actual
+}
+
+int ClockUpdate(reloj_t reloj) {
+
+    return ClockGetTimeAt(reloj, reloj->fuente->Leer());
+}
+
+uint32_t ClockNextEventTick(reloj_t reloj) {
+
+    return reloj->tick_referencia + reloj->ticks;
+}
+
+uint32_t ClockNextAlarmTick(reloj_t reloj, uint32_t max_segundos) {
+
+    uint32_t segundos = max_segundos;
+
+    if (reloj->hora_valida && (reloj->programadas > 0)) {
+        uint32_t disparo = reloj->alarmas[reloj->monticulo[0]].disparo;
+        segundos = (disparo > reloj->instante) ? disparo - reloj->instante : 1;
+        if (segundos > max_segundos) {
+            segundos = max_segundos;
         }
-        reloj->tick_actual = 0;
-    } else {
-        reloj->tick_actual++;
     }
-    return reloj->tick_actual;
+    return reloj->tick_referencia + segundos * reloj->ticks;
+}
+
+int AgregarAlarma(reloj_t reloj, alarma_config_t config) {
+
+    int indice;
+    alarma_t alarma;
+
+    if (reloj->cantidad_libres == 0) {
+        return SIN_ALARMA; // la tabla esta llena
+    }
+    indice = reloj->libres[--reloj->cantidad_libres];
+    alarma = &reloj->alarmas[indice];
+    memset(alarma, 0, sizeof(*alarma));
+    alarma->asignada = true;
+    alarma->hora = DataTimeASeg(config->hora);
+    alarma->dias = config->dias ? (config->dias & ALARMA_TODOS_LOS_DIAS) : ALARMA_TODOS_LOS_DIAS;
+    alarma->repetir = config->repetir;
+    Programar(reloj, indice, ProximoDisparo(reloj, alarma));
+    return indice;
+}
+
+bool BorrarAlarma(reloj_t reloj, int indice) {
+
+    if ((indice < 0) || (indice >= ALARM_INSTANCES) || !reloj->alarmas[indice].asignada) {
+        return false;
+    }
+    Desprogramar(reloj, indice);
+    reloj->alarmas[indice].asignada = false;
+    reloj->libres[reloj->cantidad_libres++] = indice;
+    if (reloj->principal == indice) {
+        reloj->principal = SIN_ALARMA;
+    }
+    if (reloj->sonando == indice) {
+        reloj->sonando = SIN_ALARMA;
+    }
+    return true;
+}
+
+bool LeerAlarma(reloj_t reloj, int indice, struct alarma_config_s * config, bool * programada) {
+
+    uint8_t vista[6];
+    alarma_t alarma;
+
+    if ((indice < 0) || (indice >= ALARM_INSTANCES) || !reloj->alarmas[indice].asignada) {
+        return false;
+    }
+    alarma = &reloj->alarmas[indice];
+    ExpandirHora(alarma->hora, vista);
+    memcpy(config->hora, vista, sizeof(config->hora));
+    config->dias = alarma->dias;
+    config->repetir = alarma->repetir;
+    *programada = alarma->en_monticulo;
+    return true;
+}
+
+int AlarmaSonando(reloj_t reloj) {
+
+    return reloj->sonando;
 }
 
 bool SetAlarmTime(reloj_t reloj, const uint8_t * alarma) {
     // No me debería dejar setear una alarma si nunca se configuró la hora
 
-    memcpy(reloj->alarma, alarma, 4);
-    reloj->alarma_habilitada = true;
-    return true;
+    BorrarAlarma(reloj, reloj->principal);
+    reloj->principal = AgregarAlarma(reloj, &(struct alarma_config_s){
+                                                .hora = {alarma[0], alarma[1], alarma[2], alarma[3]},
+                                                .dias = ALARMA_TODOS_LOS_DIAS,
+                                                .repetir = true,
+                                            });
+    return reloj->principal != SIN_ALARMA;
 }
 
 bool GetAlarmTime(reloj_t reloj, uint8_t * alarma) {
 
-    memcpy(alarma, reloj->alarma, 4);
-    return reloj->alarma_habilitada;
+    uint32_t hora = 0;
+    alarma_t principal = NULL;
+
+    if (reloj->principal != SIN_ALARMA) {
+        principal = &reloj->alarmas[reloj->principal];
+        hora = principal->hora;
+    }
+    alarma[0] = hora / 36000;
+    alarma[1] = (hora / 3600) % 10;
+    alarma[2] = (hora / 600) % 6;
+    alarma[3] = (hora / 60) % 10;
+    return (principal != NULL) && principal->en_monticulo;
 }
 
-// La funcion pasa hora_actual y alarma a segundos, esto se hace para facilitar el offset de tiempo
-// que se agrega cuando se pospone la alarma, y compara cada minuto si hay coincidencia.
-// modificacion: Se hace que la funcion devuelva un booleando para saber si la alarma está sonando o
-// no. en funcion del parametro 'mode' la funcion disparará la alarma o avisará que está sonando al
-// encontrar coincidencia
-// mode = 1 : al haber coincidencia dispara la alarma y retorna 1
-// mode = 0 : al haber coincidencia no dispara y retorna 1 y si no hubo coincidencia retorna 0
+// Solo se compara contra la cabeza del monticulo, por lo que el costo cuando no hay nada que
+// disparar es constante sin importar cuantas alarmas haya programadas.
 void VerificarAlarma(reloj_t reloj) {
-    // Necesito verificar alarma solo cada minuto:
-
-    if ((reloj->hora_actual[4] == 0) && (reloj->hora_actual[5] == 0)) {
 
-        // Convierto hora_actual y alarma a segundos, sumo el snooze a alarma y comparo.
-        uint32_t hora_actual = DataTimeASeg(reloj->hora_actual);
-        uint32_t alarma_actual = DataTimeASeg(reloj->alarma);
-        uint32_t nueva_alarma = alarma_actual + reloj->snooze_offset;
-
-        // Verifico que nueva_alarma no supere las 24 horas
-        if (nueva_alarma >= 86400) {
-            nueva_alarma -= 86400;
-        }
-        if ((hora_actual == nueva_alarma) & (reloj->alarma_habilitada)) {
-            reloj->disparar_alarma(reloj, true);
+    while ((reloj->programadas > 0) &&
+           (reloj->alarmas[reloj->monticulo[0]].disparo <= reloj->instante)) {
+        int indice = reloj->monticulo[0];
+        alarma_t alarma = &reloj->alarmas[indice];
+
+        alarma->ultimo = alarma->disparo;
+        alarma->snooze = 0;
+        if (alarma->repetir) {
+            Programar(reloj, indice, ProximoDisparo(reloj, alarma));
+        } else {
+            Desprogramar(reloj, indice);
         }
+        reloj->sonando = indice;
+        reloj->disparar_alarma(reloj, true);
     }
 }
 
 void ToggleHabAlarma(reloj_t reloj) {
 
-    reloj->alarma_habilitada ^= 1;
-    reloj->snooze_offset = 0;
+    if (reloj->principal == SIN_ALARMA) {
+        SetAlarmTime(reloj, (uint8_t[]){0, 0, 0, 0}); // se habilita la alarma por defecto
+        return;
+    }
+    alarma_t alarma = &reloj->alarmas[reloj->principal];
+    alarma->snooze = 0;
+    if (alarma->en_monticulo) {
+        Desprogramar(reloj, reloj->principal);
+    } else {
+        Programar(reloj, reloj->principal, ProximoDisparo(reloj, alarma));
+    }
 }
 
+// Pospone la alarma que esta sonando. El snooze se acumula sobre la hora del ultimo disparo, asi
+// la alarma vuelve a sonar en un minuto exacto.
 void PosponerAlarma(reloj_t reloj, uint8_t minutos) {
 
-    reloj->snooze_offset += minutos * 60;
+    if (reloj->sonando != SIN_ALARMA) {
+        alarma_t alarma = &reloj->alarmas[reloj->sonando];
+        alarma->snooze += minutos * 60;
+        Programar(reloj, reloj->sonando, alarma->ultimo + alarma->snooze);
+    }
     reloj->disparar_alarma(reloj, false);
 }
 
 void CancelarAlarma(reloj_t reloj) {
-    reloj->snooze_offset = 0;
+
+    if (reloj->sonando != SIN_ALARMA) {
+        alarma_t alarma = &reloj->alarmas[reloj->sonando];
+        if (!alarma->repetir) {
+            BorrarAlarma(reloj, reloj->sonando); // una alarma de un solo uso no vuelve a sonar
+        } else if (alarma->snooze != 0) {
+            alarma->snooze = 0;
+            Programar(reloj, reloj->sonando, ProximoDisparo(reloj, alarma));
+        }
+        reloj->sonando = SIN_ALARMA;
+    }
     reloj->disparar_alarma(reloj, false);
 }
 
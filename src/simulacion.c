@@ -0,0 +1,171 @@
+/************************************************************************************************
+Copyright (c) 2023, Emiliano Arnedo <emiarnedo@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+
+/** \brief Guiones de teclas y tiempo para simular el reloj en posix
+ **
+ ** Solo se compila para posix. En los microcontroladores no hay de donde leer un guion.
+ **
+ ** \addtogroup simulacion Simulacion
+ ** \brief Guiones de teclas y tiempo para la simulacion
+ ** @{ */
+
+/* === Headers files inclusions =============================================================== */
+
+#include "simulacion.h"
+#include "tiempo.h"
+
+#if defined(POSIX)
+    #include <stdlib.h>
+    #include <string.h>
+#endif
+
+/* === Macros definitions ====================================================================== */
+
+#define LARGO_NOMBRE   8 // largo maximo del nombre de un evento
+#define MAX_PENDIENTES 4 // eventos de alarma entre dos pasos del guion
+
+/* === Private data type declarations ========================================================== */
+
+/* === Private variable declarations =========================================================== */
+
+#if defined(POSIX)
+// Nombres de los eventos que se pueden inyectar, en el orden de evento_t
+static const char * const NOMBRES[] = {
+    [EVENTO_F1] = "F1",           [EVENTO_F2] = "F2",
+    [EVENTO_F3] = "F3",           [EVENTO_F4] = "F4",
+    [EVENTO_ACEPTAR] = "ACEPTAR", [EVENTO_CANCELAR] = "CANCELAR",
+};
+#endif
+
+/* === Private function declarations =========================================================== */
+
+#if defined(POSIX)
+static const char * SaltarBlancos(const char * texto);
+static bool LeerEvento(const char * nombre, int largo, evento_t * evento);
+static void ProcesarPendientes(modos_t modos);
+#endif
+
+/* === Public variable definitions ============================================================= */
+
+/* === Private variable definitions ============================================================ */
+
+#if defined(POSIX)
+// Eventos de alarma que genera el reloj, que se procesan despues como los bits de eventos en main
+static struct {
+    evento_t pendientes[MAX_PENDIENTES];
+    int cantidad;
+    int alarmas;
+} simulacion;
+#endif
+
+/* === Private function implementation ========================================================= */
+
+#if defined(POSIX)
+static const char * SaltarBlancos(const char * texto) {
+    while (*texto == ' ' || *texto == '\t' || *texto == '\r') {
+        texto++;
+    }
+    return texto;
+}
+
+static bool LeerEvento(const char * nombre, int largo, evento_t * evento) {
+    if (largo == 1 && nombre[0] == '-') {
+        *evento = SIMULACION_SIN_EVENTO;
+        return true;
+    }
+    for (size_t i = 0; i < sizeof(NOMBRES) / sizeof(NOMBRES[0]); i++) {
+        if (strlen(NOMBRES[i]) == (size_t)largo && strncmp(NOMBRES[i], nombre, largo) == 0) {
+            *evento = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void ProcesarPendientes(modos_t modos) {
+    for (int i = 0; i < simulacion.cantidad; i++) {
+        ModosProcesar(modos, simulacion.pendientes[i]);
+    }
+    simulacion.cantidad = 0;
+}
+#endif
+
+/* === Public function implementation ========================================================== */
+
+#if defined(POSIX)
+int SimulacionLeerGuion(const char * texto, simulacion_paso_t * guion, int maximo) {
+    int pasos = 0;
+    const char * nombre;
+    char * fin;
+    int largo;
+
+    while (*texto) {
+        texto = SaltarBlancos(texto);
+        if (*texto != '#' && *texto != '\n' && *texto != '\0') {
+            if (pasos == maximo) {
+                return -1;
+            }
+            guion[pasos].segundos = strtoul(texto, &fin, 10);
+            nombre = SaltarBlancos(fin);
+            largo = strcspn(nombre, " \t\r\n#");
+            if (fin == texto || largo > LARGO_NOMBRE ||
+                !LeerEvento(nombre, largo, &guion[pasos].evento)) {
+                return -1;
+            }
+            pasos++;
+            texto = SaltarBlancos(nombre + largo);
+            if (*texto != '#' && *texto != '\n' && *texto != '\0') {
+                return -1; // sobra algo en la linea
+            }
+        }
+        texto += strcspn(texto, "\n");
+        if (*texto == '\n') {
+            texto++;
+        }
+    }
+    return pasos;
+}
+
+void SimulacionAlarma(reloj_t reloj, bool act_desact) {
+    (void)reloj;
+    if (act_desact) {
+        simulacion.alarmas++;
+    }
+    if (simulacion.cantidad < MAX_PENDIENTES) {
+        simulacion.pendientes[simulacion.cantidad++] =
+            act_desact ? EVENTO_ALARMA_SONANDO : EVENTO_ALARMA_CALLADA;
+    }
+}
+
+int SimulacionEjecutar(modos_t modos, reloj_t reloj, const simulacion_paso_t * guion, int pasos) {
+    simulacion.cantidad = 0;
+    simulacion.alarmas = 0;
+    for (int i = 0; i < pasos; i++) {
+        SimulacionAvanzar(guion[i].segundos * 1000);
+        ClockUpdate(reloj);
+        ProcesarPendientes(modos);
+        ModosProcesar(modos, guion[i].evento);
+        ProcesarPendientes(modos); // cancelar la alarma tambien genera un evento
+    }
+    return simulacion.alarmas;
+}
+#endif
+
+/* === End of documentation ==================================================================== */
+
+/** @} End of module definition for doxygen */
@@ -0,0 +1,258 @@
+/************************************************************************************************
+Copyright (c) 2023, Emiliano Arnedo <emiarnedo@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** \brief Fuentes de tiempo por hardware para el reloj
+ **
+ ** El RTC del LPC43xx lleva la fecha en registros separados, que se convierten a segundos desde
+ ** el 1 de enero de 2000. El del STM32F1 ya es un contador de segundos de 32 bits. En ambos el
+ ** aviso de cada segundo usa la interrupcion de incremento del contador.
+ **
+ ** \addtogroup tiempo Tiempo
+ ** \brief Fuentes de tiempo por hardware
+ ** @{ */
+
+/* === Headers files inclusions =============================================================== */
+
+#include "tiempo.h"
+
+#if defined(LPC43XX)
+    #include "chip.h"
+#elif defined(STM32F1XX)
+    #include "stm32f1xx.h"
+#elif defined(POSIX)
+    #include <time.h>
+#endif
+
+/* === Macros definitions ====================================================================== */
+
+//! Prioridad de la interrupcion del RTC, que usa la API de FreeRTOS desde el aviso
+#if !defined(RTC_NVIC_PRIORITY)
+    #define RTC_NVIC_PRIORITY 6
+#endif
+
+#define SEGUNDOS_POR_DIA (24 * 60 * 60)
+
+/* === Private data type declarations ========================================================== */
+
+/* === Private variable declarations =========================================================== */
+
+/* === Private function declarations =========================================================== */
+
+#if defined(LPC43XX) || defined(STM32F1XX)
+static void IniciarRtc(void);
+static uint32_t LeerRtc(void);
+static void AvisarSegundoRtc(void (*aviso)(void));
+#endif
+
+#if defined(POSIX)
+static uint32_t LeerMonotonica(void);
+static uint32_t LeerSimulada(void);
+#endif
+
+/* === Public variable definitions ============================================================= */
+
+#if defined(LPC43XX) || defined(STM32F1XX)
+const reloj_fuente_t FUENTE_RTC = &(struct reloj_fuente_s){
+    .Iniciar = IniciarRtc,
+    .Leer = LeerRtc,
+    .frecuencia = 1,
+    .AvisarSegundo = AvisarSegundoRtc,
+};
+#endif
+
+#if defined(POSIX)
+const reloj_fuente_t FUENTE_MONOTONICA = &(struct reloj_fuente_s){
+    .Leer = LeerMonotonica,
+    .frecuencia = 1000,
+};
+
+const reloj_fuente_t FUENTE_SIMULADA = &(struct reloj_fuente_s){
+    .Leer = LeerSimulada,
+    .frecuencia = 1000,
+};
+#endif
+
+/* === Private variable definitions ============================================================ */
+
+#if defined(LPC43XX) || defined(STM32F1XX)
+static void (*aviso_segundo)(void);
+#endif
+
+#if defined(POSIX)
+// El tiempo simulado es 'base' mas lo que avanzo a 'velocidad' desde 'referencia', en tiempo real
+static struct {
+    uint32_t base;
+    uint32_t referencia;
+    uint32_t velocidad;
+} simulacion;
+#endif
+
+/* === Private function implementation ========================================================= */
+
+#if defined(LPC43XX)
+
+static void IniciarRtc(void) {
+    // Si el RTC ya estaba contando, con la bateria de respaldo, no se toca
+    if ((LPC_RTC->CCR & RTC_CCR_CLKEN) == 0) {
+        Chip_RTC_Init(LPC_RTC);
+        Chip_RTC_SetFullTime(LPC_RTC, &(RTC_TIME_T){
+                                          .time[RTC_TIMETYPE_DAYOFMONTH] = 1,
+                                          .time[RTC_TIMETYPE_DAYOFYEAR] = 1,
+                                          .time[RTC_TIMETYPE_MONTH] = 1,
+                                          .time[RTC_TIMETYPE_YEAR] = 2000,
+                                      });
+        Chip_RTC_Enable(LPC_RTC, ENABLE);
+    }
+    NVIC_SetPriority(RTC_IRQn, RTC_NVIC_PRIORITY);
+}
+
+static uint32_t LeerRtc(void) {
+    uint32_t tiempo0, tiempo1, tiempo2, anios, dias;
+
+    // Los tres registros consolidados se vuelven a leer si el segundo cambio entre las lecturas
+    do {
+        tiempo0 = LPC_RTC->CTIME[0];
+        tiempo1 = LPC_RTC->CTIME[1];
+        tiempo2 = LPC_RTC->CTIME[2];
+    } while (tiempo0 != LPC_RTC->CTIME[0]);
+
+    anios = ((tiempo1 & RTC_CTIME1_YEAR_MASK) >> 16) - 2000;
+    dias = anios * 365 + (anios + 3) / 4 + (tiempo2 & RTC_CTIME2_DOY_MASK) - 1;
+    return dias * SEGUNDOS_POR_DIA + ((tiempo0 & RTC_CTIME0_HOURS_MASK) >> 16) * 3600 +
+           ((tiempo0 & RTC_CTIME0_MINUTES_MASK) >> 8) * 60 + (tiempo0 & RTC_CTIME0_SECONDS_MASK);
+}
+
+static void AvisarSegundoRtc(void (*aviso)(void)) {
+    NVIC_DisableIRQ(RTC_IRQn);
+    aviso_segundo = aviso;
+    Chip_RTC_CntIncrIntConfig(LPC_RTC, RTC_AMR_CIIR_IMSEC, aviso ? ENABLE : DISABLE);
+    Chip_RTC_ClearIntPending(LPC_RTC, RTC_INT_COUNTER_INCREASE);
+    NVIC_ClearPendingIRQ(RTC_IRQn);
+    if (aviso) {
+        NVIC_EnableIRQ(RTC_IRQn);
+    }
+}
+
+void RTC_IRQHandler(void) {
+    Chip_RTC_ClearIntPending(LPC_RTC, RTC_INT_COUNTER_INCREASE);
+    if (aviso_segundo) {
+        aviso_segundo();
+    }
+}
+
+#elif defined(STM32F1XX)
+
+static void IniciarRtc(void) {
+    RCC->APB1ENR |= RCC_APB1ENR_PWREN | RCC_APB1ENR_BKPEN;
+    PWR->CR |= PWR_CR_DBP;
+
+    // Si el RTC ya estaba contando, con la bateria de respaldo, no se toca
+    if ((RCC->BDCR & RCC_BDCR_RTCEN) == 0) {
+        RCC->BDCR |= RCC_BDCR_LSEON;
+        while ((RCC->BDCR & RCC_BDCR_LSERDY) == 0) {
+        }
+        RCC->BDCR |= RCC_BDCR_RTCSEL_LSE | RCC_BDCR_RTCEN;
+
+        while ((RTC->CRL & RTC_CRL_RTOFF) == 0) {
+        }
+        RTC->CRL |= RTC_CRL_CNF;
+        RTC->PRLH = 0;
+        RTC->PRLL = 32767; // un segundo con el cristal de 32768 Hz
+        RTC->CNTH = 0;
+        RTC->CNTL = 0;
+        RTC->CRL &= ~RTC_CRL_CNF;
+        while ((RTC->CRL & RTC_CRL_RTOFF) == 0) {
+        }
+    }
+    RTC->CRL &= ~RTC_CRL_RSF;
+    while ((RTC->CRL & RTC_CRL_RSF) == 0) {
+    }
+    NVIC_SetPriority(RTC_IRQn, RTC_NVIC_PRIORITY);
+}
+
+static uint32_t LeerRtc(void) {
+    uint32_t alta, baja;
+
+    // La parte alta se vuelve a leer por si la baja desbordo entre las dos lecturas
+    do {
+        alta = RTC->CNTH;
+        baja = RTC->CNTL;
+    } while (alta != RTC->CNTH);
+    return (alta << 16) | baja;
+}
+
+static void AvisarSegundoRtc(void (*aviso)(void)) {
+    NVIC_DisableIRQ(RTC_IRQn);
+    aviso_segundo = aviso;
+    while ((RTC->CRL & RTC_CRL_RTOFF) == 0) {
+    }
+    if (aviso) {
+        RTC->CRH |= RTC_CRH_SECIE;
+    } else {
+        RTC->CRH &= ~RTC_CRH_SECIE;
+    }
+    RTC->CRL &= ~RTC_CRL_SECF;
+    NVIC_ClearPendingIRQ(RTC_IRQn);
+    if (aviso) {
+        NVIC_EnableIRQ(RTC_IRQn);
+    }
+}
+
+void RTC_IRQHandler(void) {
+    RTC->CRL &= ~RTC_CRL_SECF;
+    if (aviso_segundo) {
+        aviso_segundo();
+    }
+}
+
+#endif
+
+#if defined(POSIX)
+static uint32_t LeerMonotonica(void) {
+    struct timespec ahora;
+
+    clock_gettime(CLOCK_MONOTONIC, &ahora);
+    return ahora.tv_sec * 1000 + ahora.tv_nsec / 1000000;
+}
+
+static uint32_t LeerSimulada(void) {
+    if (simulacion.velocidad == 0) {
+        return simulacion.base;
+    }
+    return simulacion.base + (LeerMonotonica() - simulacion.referencia) * simulacion.velocidad;
+}
+#endif
+
+/* === Public function implementation ========================================================== */
+
+#if defined(POSIX)
+void SimulacionVelocidad(uint32_t velocidad) {
+    uint32_t ahora = LeerMonotonica();
+
+    simulacion.base = LeerSimulada();
+    simulacion.referencia = ahora;
+    simulacion.velocidad = velocidad;
+}
+
+void SimulacionAvanzar(uint32_t milisegundos) {
+    simulacion.base += milisegundos;
+}
+#endif
+
+/* === End of documentation ==================================================================== */
+
+/** @} End of module definition for doxygen */